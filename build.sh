@@ -1,19 +1,92 @@
 #!/bin/sh
 
-SOURCE_FILES="src/main.c"
-RENDER_SOURCE_FILES="src/render/microui.c src/render/renderer.c"
+SOURCE_FILES="src/main.c src/frametime.c src/truncate.c"
+RENDER_SOURCE_FILES="src/render/microui.c src/render/renderer.c src/render/glyphs.c src/render/recording.c src/render/damage.c"
+AUDIO_SOURCE_FILES="src/audio/fft.c src/audio/spectrum.c src/audio/analysis.c src/audio/meter.c src/audio/loudness.c"
+LIBRARY_SOURCE_FILES="src/library/library.c src/library/waveform.c src/library/tempo.c"
 
-SDL="$(pkg-config --cflags --libs sdl2,SDL2_mixer)"
+SDL="$(pkg-config --cflags --libs sdl2,SDL2_mixer,SDL2_ttf)"
 STDFlAGS="$SDL -Iinclude -lm -Wall -O2"
 
 OUTPUT="sap"
+ATLAS="src/render/atlas_rgba.h"
 
 TARGET="$1"
 
+# the rgba font atlas is baked into a header before compiling sap
+atlas() {
+  cc src/render/atlasgen.c -Wall -O2 -o atlasgen && ./atlasgen $ATLAS && rm atlasgen
+}
+
 if [ "$TARGET" = "" ]; then
   set -x
 
-  cc $SOURCE_FILES $RENDER_SOURCE_FILES $STDFlAGS -o $OUTPUT
+  atlas || exit 1
+  cc $SOURCE_FILES $RENDER_SOURCE_FILES $AUDIO_SOURCE_FILES $LIBRARY_SOURCE_FILES $STDFlAGS -o $OUTPUT
+elif [ "$TARGET" = "tsan" ]; then
+  set -x
+
+  atlas || exit 1
+  cc $SOURCE_FILES $RENDER_SOURCE_FILES $AUDIO_SOURCE_FILES $LIBRARY_SOURCE_FILES $STDFlAGS -g -O1 -fsanitize=thread -o $OUTPUT-tsan
+elif [ "$TARGET" = "replay" ]; then
+  set -x
+
+  atlas || exit 1
+  cc src/replay.c $RENDER_SOURCE_FILES $STDFlAGS -o $OUTPUT-replay
+elif [ "$TARGET" = "test" ]; then
+  set -x
+
+  # every kernel the cpu has is checked, the others report themselves skipped
+  cc tests/meter_test.c src/audio/meter.c $STDFlAGS -o meter-test || exit 1
+
+  for isa in scalar sse2 avx2 neon; do
+    SAP_METER_ISA=$isa ./meter-test || exit 1
+  done
+
+  rm meter-test
+
+  cc tests/fft_test.c src/audio/fft.c $STDFlAGS -o fft-test || exit 1
+  ./fft-test || exit 1
+
+  rm fft-test
+
+  cc tests/loudness_test.c $AUDIO_SOURCE_FILES $STDFlAGS -o loudness-test || exit 1
+  ./loudness-test || exit 1
+
+  rm loudness-test
+
+  # races are reported by ThreadSanitizer, which then exits non zero
+  cc tests/analysis_stress.c $AUDIO_SOURCE_FILES $STDFlAGS -g -O1 -fsanitize=thread -o analysis-stress || exit 1
+  ./analysis-stress || exit 1
+
+  rm analysis-stress
+
+  # the renderer runs headless on the software renderer
+  atlas || exit 1
+  cc tests/quad_stress.c $RENDER_SOURCE_FILES $STDFlAGS -o quad-stress || exit 1
+  ./quad-stress || exit 1
+
+  rm quad-stress
+
+  cc tests/push_bench.c $RENDER_SOURCE_FILES $STDFlAGS -o push-bench || exit 1
+  ./push-bench || exit 1
+
+  rm push-bench
+
+  cc tests/glyph_bench.c src/render/glyphs.c $STDFlAGS -o glyph-bench || exit 1
+  ./glyph-bench || exit 1
+
+  rm glyph-bench
+
+  cc tests/pool_test.c src/render/microui.c $STDFlAGS -o pool-test || exit 1
+  ./pool-test || exit 1
+
+  rm pool-test
+
+  cc tests/truncate_bench.c src/truncate.c $RENDER_SOURCE_FILES $STDFlAGS -o truncate-bench || exit 1
+  ./truncate-bench || exit 1
+
+  rm truncate-bench
 elif [ "$TARGET" = "install" ]; then
   set -x
 
@@ -0,0 +1,41 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stdint.h>
+
+#include <meter.h>
+
+#define ANALYSIS_MAX_BARS 128
+
+typedef struct {
+  int bars;
+  float min_freq, max_freq;
+  /* smoothing time constants in seconds, peak fall in dB per second */
+  float attack, decay;
+  float peak_decay;
+} analysis_config;
+
+typedef struct {
+  int bars;
+  float levels[ANALYSIS_MAX_BARS];
+  float peaks[ANALYSIS_MAX_BARS];
+  /* per channel over the blocks behind this frame, clips since start */
+  float rms_db[METER_CHANNELS];
+  float peak_db[METER_CHANNELS];
+  int clipped[METER_CHANNELS];
+  /* LUFS over 400 ms, 3 s and the gated programme, dBTP since the last reset */
+  float momentary_lufs;
+  float short_term_lufs;
+  float integrated_lufs;
+  float true_peak_db;
+  unsigned serial;
+} analysis_frame;
+
+void analysis_init(int sample_rate, const analysis_config *config, uint32_t wake_event);
+void analysis_configure(const analysis_config *config);
+void analysis_push(const int16_t *samples, int frames);
+void analysis_reset_loudness(void);
+const analysis_frame *analysis_latest(void);
+void analysis_shutdown(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <stdbool.h>
+
+#include <microui.h>
+
+/* separate damaged areas kept apart before they are merged */
+#define DAMAGE_MAX_RECTS 8
+
+int damage_update(mu_Context *ctx, mu_Rect *rects);
+void damage_add(mu_Rect rect);
+
+#endif
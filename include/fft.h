@@ -0,0 +1,19 @@
+#ifndef FFT_H
+#define FFT_H
+
+typedef struct {
+  int size;
+  int half;
+  int *bitrev;
+  /* twiddles for the size/2 point complex transform */
+  float *tw_re, *tw_im;
+  /* twiddles for splitting the packed result into the real spectrum */
+  float *split_re, *split_im;
+  float *re, *im;
+} fft_plan;
+
+fft_plan *fft_create(int size);
+void fft_destroy(fft_plan *plan);
+void fft_power(fft_plan *plan, const float *input, float *power);
+
+#endif
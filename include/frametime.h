@@ -0,0 +1,58 @@
+#ifndef FRAMETIME_H
+#define FRAMETIME_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* frames kept for the overlay and the dump */
+#define FRAMETIME_HISTORY 256
+
+enum {
+  FRAMETIME_EVENTS,
+  FRAMETIME_WAIT,
+  FRAMETIME_VISUALIZER,
+  FRAMETIME_LOUDNESS,
+  FRAMETIME_PLAYER,
+  FRAMETIME_FILES,
+  FRAMETIME_QUEUE,
+  FRAMETIME_SETTINGS,
+  FRAMETIME_DOWNLOAD,
+  FRAMETIME_OVERLAY,
+  FRAMETIME_MU_END,
+  FRAMETIME_COMMANDS,
+  FRAMETIME_FLUSH,
+  FRAMETIME_PRESENT,
+  FRAMETIME_PHASES
+};
+
+typedef struct {
+  /* milliseconds spent in each phase */
+  float ms[FRAMETIME_PHASES];
+  float total_ms;
+  /* false when the command list was unchanged and nothing was drawn */
+  bool drawn;
+  int quads;
+  int batches;
+  int command_bytes;
+  /* the most the growable microui lists have ever held */
+  int command_peak;
+  int root_peak;
+  int container_peak;
+  int id_peak;
+  /* made by the renderer, and the change in live SDL allocations */
+  int allocations;
+  int sdl_allocations;
+} frametime_record;
+
+extern const char *frametime_names[FRAMETIME_PHASES];
+
+void frametime_enable(bool enabled);
+bool frametime_enabled(void);
+void frametime_begin(void);
+void frametime_mark(int phase);
+void frametime_end(void);
+frametime_record *frametime_current(void);
+int frametime_read(frametime_record *out, int max);
+bool frametime_dump(FILE *f);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+/* the font atlas texture, the fixed ascii atlas sits in its top left corner */
+#define GLYPH_ATLAS_SIZE 512
+#define GLYPH_CAPACITY 2048
+
+typedef struct {
+  int codepoint;
+  SDL_Rect rect;
+  float uv[4];
+  unsigned last_used;
+  int next;
+} glyph;
+
+void glyphs_init(unsigned char *pixels, int reserved_w, int reserved_h, int max_height);
+const glyph *glyphs_get(int codepoint, unsigned frame, void (*before_evict)(void));
+bool glyphs_take_dirty(SDL_Rect *rect);
+unsigned glyphs_generation(void);
+unsigned glyphs_rasterized(void);
+int glyphs_decode(const char **text);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <stdbool.h>
+
+enum {
+  LIBRARY_SILENCE  = (1 << 0),
+  LIBRARY_NOAUDIO  = (1 << 1),
+  LIBRARY_WAVEFORM = (1 << 2),
+  LIBRARY_TEMPO    = (1 << 3),
+  LIBRARY_ANALYSED = LIBRARY_SILENCE | LIBRARY_WAVEFORM | LIBRARY_TEMPO
+};
+
+typedef struct {
+  char path[1024];
+  long long mtime;
+  long long size;
+  int flags;
+  /* first and last non-silent position, in milliseconds */
+  int lead_ms;
+  int trail_ms;
+  /* beat grid, bpm is 0 when the track has no steady beat */
+  float bpm;
+  int beat_ms;
+} library_entry;
+
+void library_init(const char *index_path);
+void library_add_dir(const char *dir);
+bool library_lookup(const char *path, library_entry *entry);
+bool library_waveform_path(const char *path, char *out, int len);
+int library_pending(void);
+void library_cancel(void);
+void library_shutdown(void);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include <stdint.h>
+
+/* gating blocks quieter than this never count towards integrated loudness */
+#define LOUDNESS_ABSOLUTE_GATE (-70.0f)
+
+#define LOUDNESS_HISTORY 30
+#define LOUDNESS_BINS 800
+
+/* taps per phase of the 4x true peak interpolator */
+#define LOUDNESS_TAPS 12
+
+typedef struct {
+  double b[3], a[3];
+} loudness_biquad;
+
+typedef struct {
+  float rate;
+  int block_frames;
+
+  /* k-weighting, a high shelf followed by a high pass */
+  loudness_biquad shelf, highpass;
+  double state[2][2][2];
+
+  /* 100 ms sub-blocks of summed channel power, newest at history_head - 1 */
+  double energy;
+  int block_fill;
+  double history[LOUDNESS_HISTORY];
+  int history_head;
+  int history_count;
+
+  /* 400 ms gating blocks above the absolute gate, binned by loudness in
+  ** 0.1 LU steps, so the gated mean never needs the whole programme */
+  double bin_energy[LOUDNESS_BINS];
+  int bin_count[LOUDNESS_BINS];
+
+  /* tail of the previous call for the true peak interpolator */
+  float tail[2][LOUDNESS_TAPS - 1];
+  float true_peak;
+
+  float momentary;
+  float short_term;
+  float integrated;
+} loudness;
+
+loudness *loudness_create(float sample_rate);
+void loudness_destroy(loudness *l);
+void loudness_reset(loudness *l);
+void loudness_process(loudness *l, const int16_t *samples, int frames);
+float loudness_true_peak_db(const loudness *l);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef METER_H
+#define METER_H
+
+#include <stdint.h>
+
+/* sap always opens the device as interleaved stereo s16 */
+#define METER_CHANNELS 2
+
+/* magnitudes saturate at 32767, anything at that level counts as clipped */
+#define METER_CLIP_LEVEL 32767
+
+typedef struct {
+  long long sum_squares[METER_CHANNELS];
+  int peak[METER_CHANNELS];
+  int clipped[METER_CHANNELS];
+  int frames;
+} meter_block;
+
+void meter_init(void);
+const char *meter_isa(void);
+void meter_measure(const int16_t *samples, int frames, meter_block *block);
+void meter_accumulate(meter_block *total, const meter_block *block);
+
+#endif
@@ -10,11 +10,12 @@
 
 #define MU_VERSION "2.02"
 
+/* starting sizes of the growable lists */
 #define MU_COMMANDLIST_SIZE     (256 * 1024)
 #define MU_ROOTLIST_SIZE        32
 #define MU_CONTAINERSTACK_SIZE  32
-#define MU_CLIPSTACK_SIZE       32
 #define MU_IDSTACK_SIZE         32
+#define MU_CLIPSTACK_SIZE       32
 #define MU_LAYOUTSTACK_SIZE     16
 #define MU_CONTAINERPOOL_SIZE   48
 #define MU_TREENODEPOOL_SIZE    48
@@ -24,7 +25,11 @@
 #define MU_SLIDER_FMT           "%.2f"
 #define MU_MAX_FMT              127
 
+#define MU_RETAIN_NONE          -1
+#define MU_RETAIN_REPLAYED      -2
+
 #define mu_stack(T, n)          struct { int idx; T items[n]; }
+#define mu_growable(T)          struct { int idx, cap, peak; T *items; }
 #define mu_min(a, b)            ((a) < (b) ? (a) : (b))
 #define mu_max(a, b)            ((a) > (b) ? (a) : (b))
 #define mu_clamp(x, a, b)       mu_min(b, mu_max(a, x))
@@ -40,6 +45,7 @@ enum {
   MU_COMMAND_RECT,
   MU_COMMAND_TEXT,
   MU_COMMAND_ICON,
+  MU_COMMAND_QUADS,
   MU_COMMAND_MAX
 };
 
@@ -122,12 +128,21 @@ typedef struct { int x, y, w, h; } mu_Rect;
 typedef struct { unsigned char r, g, b, a; } mu_Color;
 typedef struct { mu_Id id; int last_update; } mu_PoolItem;
 
+typedef struct {
+  mu_PoolItem *items;
+  /* open addressed on the id, holds item index + 1, 0 is empty */
+  int *slots;
+  int *free;
+  int len, mask, free_count;
+} mu_Pool;
+
 typedef struct { int type, size; } mu_BaseCommand;
 typedef struct { mu_BaseCommand base; void *dst; } mu_JumpCommand;
 typedef struct { mu_BaseCommand base; mu_Rect rect; } mu_ClipCommand;
 typedef struct { mu_BaseCommand base; mu_Rect rect; mu_Color color; } mu_RectCommand;
 typedef struct { mu_BaseCommand base; mu_Font font; mu_Vec2 pos; mu_Color color; char str[1]; } mu_TextCommand;
 typedef struct { mu_BaseCommand base; mu_Rect rect; int id; mu_Color color; } mu_IconCommand;
+typedef struct { mu_BaseCommand base; mu_Color color; int count; mu_Rect rects[1]; } mu_QuadsCommand;
 
 typedef union {
   int type;
@@ -137,6 +152,7 @@ typedef union {
   mu_RectCommand rect;
   mu_TextCommand text;
   mu_IconCommand icon;
+  mu_QuadsCommand quads;
 } mu_Command;
 
 typedef struct {
@@ -161,6 +177,15 @@ typedef struct {
   mu_Vec2 scroll;
   int zindex;
   int open;
+  /* commands kept by mu_retain() and what they were built from */
+  char *retained;
+  int retained_size, retained_cap;
+  mu_Vec2 retained_content;
+  mu_Id retained_key;
+  int retained_over;
+  /* where this frame's commands start while they are being kept, or
+  ** MU_RETAIN_REPLAYED */
+  int retain_start;
 } mu_Container;
 
 typedef struct {
@@ -196,16 +221,16 @@ struct mu_Context {
   char number_edit_buf[MU_MAX_FMT];
   mu_Id number_edit;
   /* stacks */
-  mu_stack(char, MU_COMMANDLIST_SIZE) command_list;
-  mu_stack(mu_Container*, MU_ROOTLIST_SIZE) root_list;
-  mu_stack(mu_Container*, MU_CONTAINERSTACK_SIZE) container_stack;
+  mu_growable(char) command_list;
+  mu_growable(mu_Container*) root_list;
+  mu_growable(mu_Container*) container_stack;
   mu_stack(mu_Rect, MU_CLIPSTACK_SIZE) clip_stack;
-  mu_stack(mu_Id, MU_IDSTACK_SIZE) id_stack;
+  mu_growable(mu_Id) id_stack;
   mu_stack(mu_Layout, MU_LAYOUTSTACK_SIZE) layout_stack;
-  /* retained state pools */
-  mu_PoolItem container_pool[MU_CONTAINERPOOL_SIZE];
-  mu_Container containers[MU_CONTAINERPOOL_SIZE];
-  mu_PoolItem treenode_pool[MU_TREENODEPOOL_SIZE];
+  /* retained state pools, sized by mu_init_ex */
+  mu_Pool container_pool;
+  mu_Container *containers;
+  mu_Pool treenode_pool;
   /* input state */
   mu_Vec2 mouse_pos;
   mu_Vec2 last_mouse_pos;
@@ -224,6 +249,8 @@ mu_Rect mu_rect(int x, int y, int w, int h);
 mu_Color mu_color(int r, int g, int b, int a);
 
 void mu_init(mu_Context *ctx);
+void mu_init_ex(mu_Context *ctx, int containers, int treenodes);
+void mu_free(mu_Context *ctx);
 void mu_begin(mu_Context *ctx);
 void mu_end(mu_Context *ctx);
 void mu_set_focus(mu_Context *ctx, mu_Id id);
@@ -238,9 +265,10 @@ mu_Container* mu_get_current_container(mu_Context *ctx);
 mu_Container* mu_get_container(mu_Context *ctx, const char *name);
 void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt);
 
-int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
-int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
-void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx);
+int mu_pool_init(mu_Context *ctx, mu_Pool *pool, mu_Id id);
+int mu_pool_get(mu_Context *ctx, mu_Pool *pool, mu_Id id);
+void mu_pool_update(mu_Context *ctx, mu_Pool *pool, int idx);
+void mu_pool_remove(mu_Context *ctx, mu_Pool *pool, int idx);
 
 void mu_input_mousemove(mu_Context *ctx, int x, int y);
 void mu_input_mousedown(mu_Context *ctx, int x, int y, int btn);
@@ -257,6 +285,7 @@ void mu_draw_rect(mu_Context *ctx, mu_Rect rect, mu_Color color);
 void mu_draw_box(mu_Context *ctx, mu_Rect rect, mu_Color color);
 void mu_draw_text(mu_Context *ctx, mu_Font font, const char *str, int len, mu_Vec2 pos, mu_Color color);
 void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color);
+void mu_draw_quads(mu_Context *ctx, const mu_Rect *rects, int count, mu_Color color);
 
 void mu_layout_row(mu_Context *ctx, int items, const int *widths, int height);
 void mu_layout_width(mu_Context *ctx, int width);
@@ -293,6 +322,7 @@ int mu_begin_treenode_ex(mu_Context *ctx, const char *label, int opt);
 void mu_end_treenode(mu_Context *ctx);
 int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt);
 void mu_end_window(mu_Context *ctx);
+int mu_retain(mu_Context *ctx, unsigned version);
 void mu_open_popup(mu_Context *ctx, const char *name);
 int mu_begin_popup(mu_Context *ctx, const char *name);
 void mu_end_popup(mu_Context *ctx);
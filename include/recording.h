@@ -0,0 +1,35 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <microui.h>
+#include <damage.h>
+
+/*
+** a recording is RECORDING_MAGIC followed by one record per drawn frame:
+** the microui input behind it, the damage rects it was drawn with, the
+** size of its commands, then the commands
+** back to back in draw order with the jumps already followed. structs are
+** written as they are in memory, so recordings only replay on the same
+** kind of build that made them.
+*/
+
+#define RECORDING_MAGIC "sapcmds2"
+
+typedef struct {
+  mu_Vec2 mouse_pos;
+  mu_Vec2 scroll_delta;
+  int mouse_down, mouse_pressed;
+  int key_down, key_pressed;
+  char input_text[32];
+} recording_input;
+
+void recording_capture_input(mu_Context *ctx, recording_input *input);
+bool recording_write_header(FILE *f);
+bool recording_check_header(FILE *f);
+bool recording_write_frame(FILE *f, const recording_input *input, const mu_Rect *damage, int damage_count, mu_Context *ctx);
+bool recording_read_frame(FILE *f, recording_input *input, mu_Rect *damage, int *damage_count, char **commands, int *capacity, int *size);
+
+#endif
@@ -1,16 +1,46 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stdbool.h>
 #include <microui.h>
 
+/* icon id that draws the spectrogram texture stretched over the icon rect */
+#define SDLR_ICON_SPECTROGRAM 0x1000
+
+typedef struct {
+  int quads;
+  /* quads dropped whole by the clip rect */
+  int culled;
+  int batches;
+  double upload_ms;
+  /* text runs drawn from the cache and built anew */
+  int text_hits;
+  int text_misses;
+  /* glyphs rasterised into the atlas */
+  int glyph_misses;
+  /* heap allocations made while drawing */
+  int allocations;
+  /* pixels cleared and redrawn, the rest was kept from earlier frames */
+  int damage_pixels;
+} sdlr_stats;
+
 void sdlr_init(void);
 void sdlr_draw_rect(mu_Rect rect, mu_Color color);
 void sdlr_draw_text(const char *text, mu_Vec2 pos, mu_Color color);
 void sdlr_draw_icon(int id, mu_Rect rect, mu_Color color);
+void sdlr_draw_quads(const mu_Rect *rects, int count, mu_Color color);
  int sdlr_get_text_width(const char *text, int len);
+ int sdlr_get_text_prefixes(const char *text, int len, int *offsets, int *widths, int max);
  int sdlr_get_text_height(void);
 void sdlr_set_clip_rect(mu_Rect rect);
+void sdlr_set_damage(mu_Rect rect);
+void sdlr_draw_command(mu_Command *cmd);
 void sdlr_clear(mu_Color color);
+void sdlr_flush(void);
 void sdlr_present(void);
+void sdlr_push_spectrogram_column(const float *levels, int count, float min_db);
+const sdlr_stats *sdlr_get_stats(void);
+int sdlr_get_refresh_rate(void);
+bool sdlr_save_png(const char *path);
 
 #endif
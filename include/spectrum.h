@@ -0,0 +1,32 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <fft.h>
+
+#define SPECTRUM_MIN_DB (-90.0f)
+
+typedef struct {
+  fft_plan *fft;
+  int size;
+  int bars;
+  float min_freq, max_freq;
+  float *window;
+  float *frame;
+  float *power;
+  /* fft bins [bin_lo[i], bin_hi[i]) are grouped into bar i */
+  int *bin_lo, *bin_hi;
+  float norm;
+  /* smoothed level and falling peak per bar, in dBFS */
+  float *levels;
+  float *peaks;
+  /* smoothing time constants in seconds, peak fall in dB per second */
+  float attack, decay;
+  float peak_decay;
+} spectrum;
+
+spectrum *spectrum_create(int size, int bars, float sample_rate, float min_freq, float max_freq);
+void spectrum_destroy(spectrum *s);
+void spectrum_carry(spectrum *s, const spectrum *from);
+void spectrum_update(spectrum *s, const float *samples, float dt);
+
+#endif
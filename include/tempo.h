@@ -0,0 +1,20 @@
+#ifndef TEMPO_H
+#define TEMPO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+  /* 0 when no steady beat was found */
+  float bpm;
+  /* position of the first beat of the grid, in milliseconds */
+  int beat_ms;
+} tempo_result;
+
+/* polled every few hundred frames, analysis stops once it returns true */
+typedef bool (*tempo_cancel)(void *data);
+
+bool tempo_analyse(const int16_t *samples, int frames, int channels, int sample_rate,
+                   tempo_result *result, tempo_cancel cancelled, void *data);
+
+#endif
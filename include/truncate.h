@@ -0,0 +1,8 @@
+#ifndef TRUNCATE_H
+#define TRUNCATE_H
+
+#include <microui.h>
+
+int truncate_text(mu_Context *ctx, char *text);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* frames summarised by one bucket of the finest level */
+#define WAVEFORM_BUCKET 1024
+
+typedef struct {
+  int levels;
+  /* level i has counts[i] buckets of WAVEFORM_BUCKET << i frames */
+  int *counts;
+  int8_t **min, **max;
+} waveform;
+
+bool waveform_build(const int16_t *samples, int frames, int channels,
+                    const char *track, const char *path);
+waveform *waveform_load(const char *path, const char *track);
+void waveform_free(waveform *wf);
+void waveform_columns(const waveform *wf, int columns, int8_t *min, int8_t *max);
+
+#endif
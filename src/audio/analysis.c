@@ -0,0 +1,284 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <SDL2/SDL.h>
+
+#include <analysis.h>
+#include <spectrum.h>
+#include <loudness.h>
+
+/*
+** the audio callback meters its output, downmixes and decimates it into
+** fixed size blocks and hands them over through a single producer single consumer ring.
+** the analysis thread drains the ring, runs the spectrum and publishes the
+** result through a triple buffer, so neither side ever takes a lock and the
+** audio thread never waits. configuration changes from the ui are picked up
+** by the analysis thread between two updates, which is the only place the
+** spectrum buffers are reallocated. blocks also carry the full rate stereo
+** they were made from, which the loudness meter works through incrementally.
+** every handoff uses C11 atomics, which ThreadSanitizer can follow, unlike
+** the spin locks compiled into SDL.
+*/
+
+#define BLOCK_SIZE 256
+#define RING_BLOCKS 64
+#define SPECTRUM_SIZE 2048
+
+#define FRAME_FRESH 4
+
+typedef struct {
+  float samples[BLOCK_SIZE];
+  /* the 2 * BLOCK_SIZE interleaved stereo frames behind `samples` */
+  int16_t raw[BLOCK_SIZE * 4];
+  meter_block meter;
+} block;
+
+static block ring[RING_BLOCKS];
+static atomic_uint ring_head;
+static atomic_uint ring_tail;
+static atomic_uint dropped_blocks;
+
+/* owned by the audio thread */
+static block pending;
+static int pending_count = 0;
+
+static analysis_frame frames[3];
+static atomic_int middle_frame = 2;
+/* owned by the analysis thread */
+static int back_frame = 1;
+static unsigned published = 0;
+/* owned by the ui thread */
+static int front_frame = 0;
+
+/* pushed once per visible change while the ui is armed */
+static Uint32 wake_event = 0;
+static atomic_int wake_armed = 1;
+static analysis_frame last_frame;
+
+static spectrum *analyzer;
+static float history[SPECTRUM_SIZE];
+static float rate;
+static meter_block meter;
+static float rms_db[METER_CHANNELS] = { SPECTRUM_MIN_DB, SPECTRUM_MIN_DB };
+static float peak_db[METER_CHANNELS] = { SPECTRUM_MIN_DB, SPECTRUM_MIN_DB };
+static int clipped[METER_CHANNELS];
+static loudness *lufs;
+static atomic_int lufs_reset;
+
+static analysis_config config;
+static atomic_flag config_lock = ATOMIC_FLAG_INIT;
+static atomic_int config_changed;
+
+static SDL_sem *ready;
+static SDL_Thread *worker;
+static atomic_int quit;
+
+static void push_block(void) {
+  unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+
+  pending_count = 0;
+
+  if (head - tail == RING_BLOCKS) {
+    atomic_fetch_add_explicit(&dropped_blocks, 1, memory_order_relaxed);
+    return;
+  }
+
+  ring[head % RING_BLOCKS] = pending;
+  atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+
+  memset(&pending.meter, 0, sizeof(pending.meter));
+
+  SDL_SemPost(ready);
+}
+
+/* audio thread: interleaved stereo s16 as handed to the post mix hook */
+void analysis_push(const int16_t *samples, int frames) {
+  meter_measure(samples, frames, &pending.meter);
+
+  for (int i = 0; i + 1 < frames; i += 2) {
+    int sum = samples[2 * i] + samples[2 * i + 1] + samples[2 * i + 2] + samples[2 * i + 3];
+
+    memcpy(pending.raw + pending_count * 4, samples + 2 * i, 4 * sizeof(int16_t));
+    pending.samples[pending_count++] = sum / (4 * 32768.0f);
+
+    if (pending_count == BLOCK_SIZE) {
+      push_block();
+    }
+  }
+}
+
+static void apply_config(void) {
+  while (atomic_flag_test_and_set_explicit(&config_lock, memory_order_acquire));
+  analysis_config next = config;
+  atomic_flag_clear_explicit(&config_lock, memory_order_release);
+
+  float nyquist = rate / 2.0f;
+
+  next.bars = next.bars < 1 ? 1 : next.bars > ANALYSIS_MAX_BARS ? ANALYSIS_MAX_BARS : next.bars;
+  next.max_freq = next.max_freq < nyquist ? next.max_freq : nyquist;
+  next.min_freq = next.min_freq < next.max_freq / 2 ? next.min_freq : next.max_freq / 2;
+
+  /* only the bar layout needs new tables, smoothing is changed in place so
+  ** dragging its sliders does not drop the bars to the floor */
+  if (analyzer == NULL || analyzer->bars != next.bars ||
+      analyzer->min_freq != next.min_freq || analyzer->max_freq != next.max_freq) {
+    spectrum *previous = analyzer;
+
+    analyzer = spectrum_create(SPECTRUM_SIZE, next.bars, rate, next.min_freq, next.max_freq);
+
+    if (previous != NULL) {
+      spectrum_carry(analyzer, previous);
+      spectrum_destroy(previous);
+    }
+  }
+
+  analyzer->attack = next.attack;
+  analyzer->decay = next.decay;
+  analyzer->peak_decay = next.peak_decay;
+}
+
+static void publish(void) {
+  frames[back_frame].bars = analyzer->bars;
+  memcpy(frames[back_frame].levels, analyzer->levels, analyzer->bars * sizeof(float));
+  memcpy(frames[back_frame].peaks, analyzer->peaks, analyzer->bars * sizeof(float));
+  frames[back_frame].serial = ++published;
+
+  for (int c = 0; c < METER_CHANNELS && meter.frames > 0; c++) {
+    double mean_square = (double)meter.sum_squares[c] / meter.frames;
+
+    rms_db[c] = mean_square > 0 ? 10 * log10(mean_square / (32768.0 * 32768.0)) : SPECTRUM_MIN_DB;
+    peak_db[c] = meter.peak[c] > 0 ? 20 * log10(meter.peak[c] / 32768.0) : SPECTRUM_MIN_DB;
+    clipped[c] += meter.clipped[c];
+  }
+
+  memcpy(frames[back_frame].rms_db, rms_db, sizeof(rms_db));
+  memcpy(frames[back_frame].peak_db, peak_db, sizeof(peak_db));
+  memcpy(frames[back_frame].clipped, clipped, sizeof(clipped));
+
+  frames[back_frame].momentary_lufs = lufs->momentary;
+  frames[back_frame].short_term_lufs = lufs->short_term;
+  frames[back_frame].integrated_lufs = lufs->integrated;
+  frames[back_frame].true_peak_db = loudness_true_peak_db(lufs);
+
+  bool changed = memcmp(&frames[back_frame], &last_frame, offsetof(analysis_frame, serial)) != 0;
+  last_frame = frames[back_frame];
+
+  memset(&meter, 0, sizeof(meter));
+
+  int previous = atomic_exchange_explicit(&middle_frame, back_frame | FRAME_FRESH, memory_order_acq_rel);
+  back_frame = previous & ~FRAME_FRESH;
+
+  /* a settled meter fed silence stops waking the ui */
+  if (changed && wake_event != 0 && atomic_exchange(&wake_armed, 0)) {
+    SDL_Event e = { .type = wake_event };
+    SDL_PushEvent(&e);
+  }
+}
+
+static int analysis_main(void *data) {
+  while (!atomic_load(&quit)) {
+    SDL_SemWait(ready);
+
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+    if (head == tail) continue;
+
+    int consumed = 0;
+
+    if (atomic_exchange(&lufs_reset, 0)) {
+      loudness_reset(lufs);
+    }
+
+    for (; tail != head; tail++) {
+      memmove(history, history + BLOCK_SIZE, (SPECTRUM_SIZE - BLOCK_SIZE) * sizeof(float));
+      memcpy(history + SPECTRUM_SIZE - BLOCK_SIZE, ring[tail % RING_BLOCKS].samples, BLOCK_SIZE * sizeof(float));
+      meter_accumulate(&meter, &ring[tail % RING_BLOCKS].meter);
+      loudness_process(lufs, ring[tail % RING_BLOCKS].raw, 2 * BLOCK_SIZE);
+      consumed += BLOCK_SIZE;
+    }
+
+    atomic_store_explicit(&ring_tail, tail, memory_order_release);
+
+    if (atomic_exchange(&config_changed, 0)) {
+      apply_config();
+    }
+
+    spectrum_update(analyzer, history, consumed / rate);
+    publish();
+  }
+
+  return 0;
+}
+
+/* `event` is pushed when a published frame differs from the previous one */
+void analysis_init(int sample_rate, const analysis_config *initial, uint32_t event) {
+  /* blocks are decimated by two */
+  rate = sample_rate / 2.0f;
+  config = *initial;
+  wake_event = event;
+
+  meter_init();
+  apply_config();
+
+  lufs = loudness_create(sample_rate);
+
+  for (int i = 0; i < 3; i++) {
+    frames[i].bars = analyzer->bars;
+    for (int j = 0; j < ANALYSIS_MAX_BARS; j++) {
+      frames[i].levels[j] = SPECTRUM_MIN_DB;
+      frames[i].peaks[j] = SPECTRUM_MIN_DB;
+    }
+
+    memcpy(frames[i].rms_db, rms_db, sizeof(rms_db));
+    memcpy(frames[i].peak_db, peak_db, sizeof(peak_db));
+
+    frames[i].momentary_lufs = -INFINITY;
+    frames[i].short_term_lufs = -INFINITY;
+    frames[i].integrated_lufs = -INFINITY;
+    frames[i].true_peak_db = -INFINITY;
+  }
+
+  ready = SDL_CreateSemaphore(0);
+  worker = SDL_CreateThread(analysis_main, "analysis", NULL);
+}
+
+/* ui thread: takes effect with the next published frame */
+void analysis_configure(const analysis_config *next) {
+  while (atomic_flag_test_and_set_explicit(&config_lock, memory_order_acquire));
+  config = *next;
+  atomic_flag_clear_explicit(&config_lock, memory_order_release);
+
+  atomic_store(&config_changed, 1);
+}
+
+/* ui thread: starts a new integrated loudness and true peak measurement */
+void analysis_reset_loudness(void) {
+  atomic_store(&lufs_reset, 1);
+}
+
+/* ui thread: the most recently published frame, valid until the next call */
+const analysis_frame *analysis_latest(void) {
+  atomic_store(&wake_armed, 1);
+
+  if (atomic_load_explicit(&middle_frame, memory_order_relaxed) & FRAME_FRESH) {
+    int previous = atomic_exchange_explicit(&middle_frame, front_frame, memory_order_acq_rel);
+    front_frame = previous & ~FRAME_FRESH;
+  }
+
+  return &frames[front_frame];
+}
+
+void analysis_shutdown(void) {
+  atomic_store(&quit, 1);
+  SDL_SemPost(ready);
+  SDL_WaitThread(worker, NULL);
+
+  SDL_DestroySemaphore(ready);
+  spectrum_destroy(analyzer);
+  loudness_destroy(lufs);
+}
@@ -0,0 +1,156 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <fft.h>
+
+/*
+** real input of `size` samples is packed into a size/2 point complex
+** transform (even samples real, odd samples imaginary) and split afterwards.
+** the complex data is kept as separate re/im arrays and the twiddles of each
+** stage are stored contiguously at [half, 2 * half), so the butterflies walk
+** plain float arrays. there are no intrinsics: the wide stages are cut into
+** blocks of FFT_LANES that gcc vectorizes on its own at -O2 (check with
+** -fopt-info-vec), the two narrow stages at the start stay scalar.
+*/
+
+#define FFT_LANES 4
+
+fft_plan *fft_create(int size) {
+  fft_plan *plan = malloc(sizeof(fft_plan));
+
+  int half = size / 2;
+  int bits = 0;
+
+  while ((1 << bits) < half) bits++;
+
+  plan->size = size;
+  plan->half = half;
+  plan->bitrev = malloc(half * sizeof(int));
+  plan->tw_re = malloc(half * sizeof(float));
+  plan->tw_im = malloc(half * sizeof(float));
+  plan->split_re = malloc((half + 1) * sizeof(float));
+  plan->split_im = malloc((half + 1) * sizeof(float));
+  plan->re = malloc(half * sizeof(float));
+  plan->im = malloc(half * sizeof(float));
+
+  for (int i = 0; i < half; i++) {
+    int rev = 0;
+
+    for (int b = 0; b < bits; b++) {
+      rev |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+
+    plan->bitrev[i] = rev;
+  }
+
+  for (int h = 1; h < half; h *= 2) {
+    for (int j = 0; j < h; j++) {
+      double angle = -M_PI * j / h;
+      plan->tw_re[h + j] = cos(angle);
+      plan->tw_im[h + j] = sin(angle);
+    }
+  }
+
+  for (int k = 0; k <= half; k++) {
+    double angle = -2.0 * M_PI * k / size;
+    plan->split_re[k] = cos(angle);
+    plan->split_im[k] = sin(angle);
+  }
+
+  return plan;
+}
+
+void fft_destroy(fft_plan *plan) {
+  if (plan == NULL) return;
+
+  free(plan->bitrev);
+  free(plan->tw_re);
+  free(plan->tw_im);
+  free(plan->split_re);
+  free(plan->split_im);
+  free(plan->re);
+  free(plan->im);
+  free(plan);
+}
+
+/* one radix 2 butterfly per lane. the arrays are restrict parameters and the
+** lane count is fixed, which is what lets gcc at -O2 turn the body into
+** single vector operations: restrict on block scope pointers is not trusted
+** and a loop of unknown length is left scalar by its default cost model */
+static void butterflies(float *restrict ar, float *restrict ai,
+                        float *restrict br, float *restrict bi,
+                        const float *restrict wr, const float *restrict wi) {
+  for (int j = 0; j < FFT_LANES; j++) {
+    float tr = br[j] * wr[j] - bi[j] * wi[j];
+    float ti = br[j] * wi[j] + bi[j] * wr[j];
+
+    br[j] = ar[j] - tr;
+    bi[j] = ai[j] - ti;
+    ar[j] = ar[j] + tr;
+    ai[j] = ai[j] + ti;
+  }
+}
+
+static void transform(fft_plan *plan) {
+  float *re = plan->re;
+  float *im = plan->im;
+
+  /* stages narrower than a block */
+  for (int h = 1; h < FFT_LANES && h < plan->half; h *= 2) {
+    for (int base = 0; base < plan->half; base += 2 * h) {
+      for (int j = base; j < base + h; j++) {
+        float wr = plan->tw_re[h + j - base];
+        float wi = plan->tw_im[h + j - base];
+        float tr = re[j + h] * wr - im[j + h] * wi;
+        float ti = re[j + h] * wi + im[j + h] * wr;
+
+        re[j + h] = re[j] - tr;
+        im[j + h] = im[j] - ti;
+        re[j] += tr;
+        im[j] += ti;
+      }
+    }
+  }
+
+  for (int h = FFT_LANES; h < plan->half; h *= 2) {
+    for (int base = 0; base < plan->half; base += 2 * h) {
+      for (int j = 0; j < h; j += FFT_LANES) {
+        butterflies(re + base + j, im + base + j, re + base + h + j, im + base + h + j,
+                    plan->tw_re + h + j, plan->tw_im + h + j);
+      }
+    }
+  }
+}
+
+/* writes size/2 + 1 squared magnitudes to `power` */
+void fft_power(fft_plan *plan, const float *input, float *power) {
+  int half = plan->half;
+
+  for (int i = 0; i < half; i++) {
+    plan->re[plan->bitrev[i]] = input[2 * i];
+    plan->im[plan->bitrev[i]] = input[2 * i + 1];
+  }
+
+  transform(plan);
+
+  for (int k = 0; k <= half; k++) {
+    int a_idx = k % half;
+    int b_idx = (half - k) % half;
+
+    float a = plan->re[a_idx], b = plan->im[a_idx];
+    float c = plan->re[b_idx], d = plan->im[b_idx];
+
+    float even_re = (a + c) * 0.5f;
+    float even_im = (b - d) * 0.5f;
+    float odd_re = (b + d) * 0.5f;
+    float odd_im = (c - a) * 0.5f;
+
+    float wr = plan->split_re[k];
+    float wi = plan->split_im[k];
+
+    float re = even_re + wr * odd_re - wi * odd_im;
+    float im = even_im + wr * odd_im + wi * odd_re;
+
+    power[k] = re * re + im * im;
+  }
+}
@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <loudness.h>
+
+/*
+** loudness after itu-r bs.1770: both channels are k-weighted, their power
+** is summed into 100 ms blocks and the momentary (400 ms) and short-term
+** (3 s) values are means over the last few blocks. integrated loudness
+** gates overlapping 400 ms blocks, first at -70 LUFS and then 10 LU below
+** the mean of what passed, using a histogram of block loudness so each
+** update costs the same however long the programme runs. true peak is
+** the largest sample of a 4x polyphase interpolation of the signal.
+*/
+
+#define CHUNK 256
+
+/* the 48 tap interpolator from bs.1770 annex 2, one row per phase */
+static const float interpolator[4][LOUDNESS_TAPS] = {
+  {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+    -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+     0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+  { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+    -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+     0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+  { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+    -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+     0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+  { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+    -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+     0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+static float to_lufs(double power) {
+  return power > 0 ? -0.691 + 10 * log10(power) : -INFINITY;
+}
+
+/* coefficients for any sample rate, derived from the 48 kHz filters in the spec */
+static void k_weighting(loudness *l) {
+  double f0 = 1681.974450955533;
+  double gain = 3.999843853973347;
+  double q = 0.7071752369554196;
+
+  double k = tan(M_PI * f0 / l->rate);
+  double vh = pow(10.0, gain / 20.0);
+  double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+
+  l->shelf.b[0] = (vh + vb * k / q + k * k) / a0;
+  l->shelf.b[1] = 2.0 * (k * k - vh) / a0;
+  l->shelf.b[2] = (vh - vb * k / q + k * k) / a0;
+  l->shelf.a[1] = 2.0 * (k * k - 1.0) / a0;
+  l->shelf.a[2] = (1.0 - k / q + k * k) / a0;
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan(M_PI * f0 / l->rate);
+  a0 = 1.0 + k / q + k * k;
+
+  l->highpass.b[0] = 1.0;
+  l->highpass.b[1] = -2.0;
+  l->highpass.b[2] = 1.0;
+  l->highpass.a[1] = 2.0 * (k * k - 1.0) / a0;
+  l->highpass.a[2] = (1.0 - k / q + k * k) / a0;
+}
+
+loudness *loudness_create(float sample_rate) {
+  loudness *l = malloc(sizeof(loudness));
+
+  l->rate = sample_rate;
+  l->block_frames = sample_rate / 10;
+
+  k_weighting(l);
+  loudness_reset(l);
+
+  return l;
+}
+
+void loudness_destroy(loudness *l) {
+  free(l);
+}
+
+void loudness_reset(loudness *l) {
+  memset(l->state, 0, sizeof(l->state));
+  memset(l->history, 0, sizeof(l->history));
+  memset(l->bin_energy, 0, sizeof(l->bin_energy));
+  memset(l->bin_count, 0, sizeof(l->bin_count));
+  memset(l->tail, 0, sizeof(l->tail));
+
+  l->energy = 0;
+  l->block_fill = 0;
+  l->history_head = 0;
+  l->history_count = 0;
+  l->true_peak = 0;
+
+  l->momentary = -INFINITY;
+  l->short_term = -INFINITY;
+  l->integrated = -INFINITY;
+}
+
+static double mean_power(const loudness *l, int blocks) {
+  blocks = blocks < l->history_count ? blocks : l->history_count;
+
+  double sum = 0;
+
+  for (int i = 1; i <= blocks; i++) {
+    sum += l->history[(l->history_head - i + LOUDNESS_HISTORY) % LOUDNESS_HISTORY];
+  }
+
+  return blocks > 0 ? sum / blocks : 0;
+}
+
+static void integrate(loudness *l) {
+  double energy = 0;
+  int count = 0;
+
+  for (int i = 0; i < LOUDNESS_BINS; i++) {
+    energy += l->bin_energy[i];
+    count += l->bin_count[i];
+  }
+
+  if (count == 0) return;
+
+  /* the relative gate falls on a bin edge, which is within 0.1 LU */
+  int gate = (to_lufs(energy / count) - 10.0f - LOUDNESS_ABSOLUTE_GATE) * 10;
+  gate = gate < 0 ? 0 : gate;
+
+  energy = 0;
+  count = 0;
+
+  for (int i = gate; i < LOUDNESS_BINS; i++) {
+    energy += l->bin_energy[i];
+    count += l->bin_count[i];
+  }
+
+  l->integrated = count > 0 ? to_lufs(energy / count) : -INFINITY;
+}
+
+static void end_block(loudness *l) {
+  l->history[l->history_head] = l->energy / l->block_frames;
+  l->history_head = (l->history_head + 1) % LOUDNESS_HISTORY;
+  l->history_count += l->history_count < LOUDNESS_HISTORY;
+
+  l->energy = 0;
+  l->block_fill = 0;
+
+  l->momentary = to_lufs(mean_power(l, 4));
+  l->short_term = to_lufs(mean_power(l, 30));
+
+  /* every 100 ms closes a 400 ms gating block overlapping the last by 75% */
+  if (l->history_count >= 4 && l->momentary > LOUDNESS_ABSOLUTE_GATE) {
+    int bin = (l->momentary - LOUDNESS_ABSOLUTE_GATE) * 10;
+    bin = bin < LOUDNESS_BINS ? bin : LOUDNESS_BINS - 1;
+
+    l->bin_energy[bin] += mean_power(l, 4);
+    l->bin_count[bin]++;
+
+    integrate(l);
+  }
+}
+
+static double biquad(const loudness_biquad *f, double x, double *z) {
+  double y = f->b[0] * x + z[0];
+
+  z[0] = f->b[1] * x - f->a[1] * y + z[1];
+  z[1] = f->b[2] * x - f->a[2] * y;
+
+  return y;
+}
+
+static void true_peak(loudness *l, const int16_t *samples, int frames) {
+  float x[LOUDNESS_TAPS - 1 + CHUNK];
+
+  for (int c = 0; c < 2; c++) {
+    float peak = l->true_peak;
+
+    for (int start = 0; start < frames; start += CHUNK) {
+      int count = frames - start < CHUNK ? frames - start : CHUNK;
+
+      memcpy(x, l->tail[c], sizeof(l->tail[c]));
+
+      for (int i = 0; i < count; i++) {
+        x[LOUDNESS_TAPS - 1 + i] = samples[(start + i) * 2 + c] / 32768.0f;
+      }
+
+      for (int i = 0; i < count; i++) {
+        const float *in = x + i + LOUDNESS_TAPS - 1;
+
+        for (int p = 0; p < 4; p++) {
+          float y = 0;
+
+          for (int k = 0; k < LOUDNESS_TAPS; k++) {
+            y += interpolator[p][k] * in[-k];
+          }
+
+          y = fabsf(y);
+          peak = y > peak ? y : peak;
+        }
+      }
+
+      memcpy(l->tail[c], x + count, sizeof(l->tail[c]));
+    }
+
+    l->true_peak = peak;
+  }
+}
+
+/* interleaved stereo s16 */
+void loudness_process(loudness *l, const int16_t *samples, int frames) {
+  for (int i = 0; i < frames; i++) {
+    double power = 0;
+
+    for (int c = 0; c < 2; c++) {
+      double y = samples[i * 2 + c] / 32768.0;
+
+      y = biquad(&l->shelf, y, l->state[c][0]);
+      y = biquad(&l->highpass, y, l->state[c][1]);
+
+      power += y * y;
+    }
+
+    l->energy += power;
+
+    if (++l->block_fill == l->block_frames) {
+      end_block(l);
+    }
+  }
+
+  true_peak(l, samples, frames);
+}
+
+/* largest interpolated sample since the last reset, in dBTP */
+float loudness_true_peak_db(const loudness *l) {
+  return l->true_peak > 0 ? 20 * log10f(l->true_peak) : -INFINITY;
+}
@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+#include <meter.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define METER_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+** every kernel adds the contribution of `frames` interleaved stereo frames
+** to `block`. squares are summed as exact integers, so all kernels agree
+** bit for bit with the scalar one; the vector ones only cover whole vectors
+** and leave the remainder to it.
+*/
+
+typedef void (*measure_func)(const int16_t *samples, int frames, meter_block *block);
+
+static measure_func measure;
+static const char *isa = "scalar";
+
+static void measure_scalar(const int16_t *samples, int frames, meter_block *block) {
+  for (int i = 0; i < frames; i++) {
+    for (int c = 0; c < METER_CHANNELS; c++) {
+      int sample = samples[i * METER_CHANNELS + c];
+      int magnitude = sample < 0 ? -sample : sample;
+
+      if (magnitude > METER_CLIP_LEVEL) magnitude = METER_CLIP_LEVEL;
+
+      block->sum_squares[c] += sample * sample;
+      block->peak[c] = magnitude > block->peak[c] ? magnitude : block->peak[c];
+      block->clipped[c] += magnitude == METER_CLIP_LEVEL;
+    }
+  }
+
+  block->frames += frames;
+}
+
+#ifdef METER_X86
+__attribute__((target("sse2")))
+static void measure_sse2(const int16_t *samples, int frames, meter_block *block) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask_l = _mm_set1_epi32(0x0000ffff);
+  const __m128i mask_r = _mm_set1_epi32((int)0xffff0000);
+  const __m128i clip = _mm_set1_epi16(METER_CLIP_LEVEL);
+
+  __m128i sum_l = zero, sum_r = zero;
+  __m128i peak = zero, clips = zero;
+
+  int vectors = frames / 4;
+  int16_t lanes[8];
+
+  for (int i = 0; i < vectors; i++) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(samples + i * 8));
+
+    /* saturating abs, -32768 becomes 32767 */
+    __m128i magnitude = _mm_max_epi16(x, _mm_subs_epi16(zero, x));
+    peak = _mm_max_epi16(peak, magnitude);
+    clips = _mm_sub_epi16(clips, _mm_cmpeq_epi16(magnitude, clip));
+
+    /* multiplying by a copy with the other channel masked out leaves one
+    ** channel's square per 32 bit lane, which is then widened to 64 bits */
+    __m128i sq_l = _mm_madd_epi16(x, _mm_and_si128(x, mask_l));
+    __m128i sq_r = _mm_madd_epi16(x, _mm_and_si128(x, mask_r));
+    sum_l = _mm_add_epi64(sum_l, _mm_add_epi64(_mm_unpacklo_epi32(sq_l, zero), _mm_unpackhi_epi32(sq_l, zero)));
+    sum_r = _mm_add_epi64(sum_r, _mm_add_epi64(_mm_unpacklo_epi32(sq_r, zero), _mm_unpackhi_epi32(sq_r, zero)));
+
+    /* the 16 bit clip counters hold at most 32767 per lane */
+    if ((i & 16383) == 16383 || i == vectors - 1) {
+      _mm_storeu_si128((__m128i*)lanes, clips);
+      for (int j = 0; j < 8; j++) block->clipped[j & 1] += lanes[j];
+      clips = zero;
+    }
+  }
+
+  long long sums[2];
+
+  _mm_storeu_si128((__m128i*)sums, sum_l);
+  block->sum_squares[0] += sums[0] + sums[1];
+  _mm_storeu_si128((__m128i*)sums, sum_r);
+  block->sum_squares[1] += sums[0] + sums[1];
+
+  _mm_storeu_si128((__m128i*)lanes, peak);
+  for (int j = 0; j < 8; j++) {
+    block->peak[j & 1] = lanes[j] > block->peak[j & 1] ? lanes[j] : block->peak[j & 1];
+  }
+
+  block->frames += vectors * 4;
+
+  measure_scalar(samples + vectors * 8, frames - vectors * 4, block);
+}
+
+__attribute__((target("avx2")))
+static void measure_avx2(const int16_t *samples, int frames, meter_block *block) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i mask_l = _mm256_set1_epi32(0x0000ffff);
+  const __m256i mask_r = _mm256_set1_epi32((int)0xffff0000);
+  const __m256i clip = _mm256_set1_epi16(METER_CLIP_LEVEL);
+
+  __m256i sum_l = zero, sum_r = zero;
+  __m256i peak = zero, clips = zero;
+
+  int vectors = frames / 8;
+  int16_t lanes[16];
+
+  for (int i = 0; i < vectors; i++) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(samples + i * 16));
+
+    __m256i magnitude = _mm256_max_epi16(x, _mm256_subs_epi16(zero, x));
+    peak = _mm256_max_epi16(peak, magnitude);
+    clips = _mm256_sub_epi16(clips, _mm256_cmpeq_epi16(magnitude, clip));
+
+    __m256i sq_l = _mm256_madd_epi16(x, _mm256_and_si256(x, mask_l));
+    __m256i sq_r = _mm256_madd_epi16(x, _mm256_and_si256(x, mask_r));
+    sum_l = _mm256_add_epi64(sum_l, _mm256_add_epi64(_mm256_unpacklo_epi32(sq_l, zero), _mm256_unpackhi_epi32(sq_l, zero)));
+    sum_r = _mm256_add_epi64(sum_r, _mm256_add_epi64(_mm256_unpacklo_epi32(sq_r, zero), _mm256_unpackhi_epi32(sq_r, zero)));
+
+    if ((i & 16383) == 16383 || i == vectors - 1) {
+      _mm256_storeu_si256((__m256i*)lanes, clips);
+      for (int j = 0; j < 16; j++) block->clipped[j & 1] += lanes[j];
+      clips = zero;
+    }
+  }
+
+  long long sums[4];
+
+  _mm256_storeu_si256((__m256i*)sums, sum_l);
+  block->sum_squares[0] += sums[0] + sums[1] + sums[2] + sums[3];
+  _mm256_storeu_si256((__m256i*)sums, sum_r);
+  block->sum_squares[1] += sums[0] + sums[1] + sums[2] + sums[3];
+
+  _mm256_storeu_si256((__m256i*)lanes, peak);
+  for (int j = 0; j < 16; j++) {
+    block->peak[j & 1] = lanes[j] > block->peak[j & 1] ? lanes[j] : block->peak[j & 1];
+  }
+
+  block->frames += vectors * 8;
+
+  measure_scalar(samples + vectors * 16, frames - vectors * 8, block);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static void measure_neon(const int16_t *samples, int frames, meter_block *block) {
+  const int16x8_t clip = vdupq_n_s16(METER_CLIP_LEVEL);
+
+  int64x2_t sum_l = vdupq_n_s64(0), sum_r = vdupq_n_s64(0);
+  int16x8_t peak_l = vdupq_n_s16(0), peak_r = vdupq_n_s16(0);
+  uint16x8_t clips_l = vdupq_n_u16(0), clips_r = vdupq_n_u16(0);
+
+  int vectors = frames / 8;
+  uint16_t lanes[8];
+
+  for (int i = 0; i < vectors; i++) {
+    /* vld2 deinterleaves, val[0] holds left and val[1] right */
+    int16x8x2_t x = vld2q_s16(samples + i * 16);
+
+    int16x8_t magnitude_l = vqabsq_s16(x.val[0]);
+    int16x8_t magnitude_r = vqabsq_s16(x.val[1]);
+    peak_l = vmaxq_s16(peak_l, magnitude_l);
+    peak_r = vmaxq_s16(peak_r, magnitude_r);
+    clips_l = vsubq_u16(clips_l, vceqq_s16(magnitude_l, clip));
+    clips_r = vsubq_u16(clips_r, vceqq_s16(magnitude_r, clip));
+
+    int16x4_t lo_l = vget_low_s16(x.val[0]), hi_l = vget_high_s16(x.val[0]);
+    int16x4_t lo_r = vget_low_s16(x.val[1]), hi_r = vget_high_s16(x.val[1]);
+    sum_l = vpadalq_s32(sum_l, vmull_s16(lo_l, lo_l));
+    sum_l = vpadalq_s32(sum_l, vmull_s16(hi_l, hi_l));
+    sum_r = vpadalq_s32(sum_r, vmull_s16(lo_r, lo_r));
+    sum_r = vpadalq_s32(sum_r, vmull_s16(hi_r, hi_r));
+
+    if ((i & 16383) == 16383 || i == vectors - 1) {
+      vst1q_u16(lanes, clips_l);
+      for (int j = 0; j < 8; j++) block->clipped[0] += lanes[j];
+      vst1q_u16(lanes, clips_r);
+      for (int j = 0; j < 8; j++) block->clipped[1] += lanes[j];
+      clips_l = clips_r = vdupq_n_u16(0);
+    }
+  }
+
+  block->sum_squares[0] += vgetq_lane_s64(sum_l, 0) + vgetq_lane_s64(sum_l, 1);
+  block->sum_squares[1] += vgetq_lane_s64(sum_r, 0) + vgetq_lane_s64(sum_r, 1);
+
+  int16_t peaks[8];
+
+  vst1q_s16(peaks, peak_l);
+  for (int j = 0; j < 8; j++) block->peak[0] = peaks[j] > block->peak[0] ? peaks[j] : block->peak[0];
+  vst1q_s16(peaks, peak_r);
+  for (int j = 0; j < 8; j++) block->peak[1] = peaks[j] > block->peak[1] ? peaks[j] : block->peak[1];
+
+  block->frames += vectors * 8;
+
+  measure_scalar(samples + vectors * 16, frames - vectors * 8, block);
+}
+#endif
+
+static bool select_isa(const char *name) {
+  if (strcmp(name, "scalar") == 0) {
+    measure = measure_scalar;
+#ifdef METER_X86
+  } else if (strcmp(name, "sse2") == 0 && SDL_HasSSE2()) {
+    measure = measure_sse2;
+  } else if (strcmp(name, "avx2") == 0 && SDL_HasAVX2()) {
+    measure = measure_avx2;
+#endif
+#if defined(__ARM_NEON)
+  } else if (strcmp(name, "neon") == 0 && SDL_HasNEON()) {
+    measure = measure_neon;
+#endif
+  } else {
+    return false;
+  }
+
+  isa = name;
+  return true;
+}
+
+/* picks the widest kernel the cpu supports, SAP_METER_ISA forces one */
+void meter_init(void) {
+  const char *forced = getenv("SAP_METER_ISA");
+
+  if (forced != NULL && select_isa(forced)) {
+    return;
+  }
+
+  if (!select_isa("avx2") && !select_isa("neon") && !select_isa("sse2")) {
+    select_isa("scalar");
+  }
+}
+
+const char *meter_isa(void) {
+  return isa;
+}
+
+void meter_measure(const int16_t *samples, int frames, meter_block *block) {
+  measure(samples, frames, block);
+}
+
+void meter_accumulate(meter_block *total, const meter_block *block) {
+  for (int c = 0; c < METER_CHANNELS; c++) {
+    total->sum_squares[c] += block->sum_squares[c];
+    total->peak[c] = block->peak[c] > total->peak[c] ? block->peak[c] : total->peak[c];
+    total->clipped[c] += block->clipped[c];
+  }
+
+  total->frames += block->frames;
+}
@@ -0,0 +1,127 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <spectrum.h>
+
+spectrum *spectrum_create(int size, int bars, float sample_rate, float min_freq, float max_freq) {
+  spectrum *s = malloc(sizeof(spectrum));
+
+  int bins = size / 2 + 1;
+
+  s->fft = fft_create(size);
+  s->size = size;
+  s->bars = bars;
+  s->min_freq = min_freq;
+  s->max_freq = max_freq;
+  s->window = malloc(size * sizeof(float));
+  s->frame = malloc(size * sizeof(float));
+  s->power = malloc(bins * sizeof(float));
+  s->bin_lo = malloc(bars * sizeof(int));
+  s->bin_hi = malloc(bars * sizeof(int));
+  s->levels = malloc(bars * sizeof(float));
+  s->peaks = malloc(bars * sizeof(float));
+  s->attack = 0.01f;
+  s->decay = 0.3f;
+  s->peak_decay = 20.0f;
+
+  /* hann window; a full scale sine then peaks at (size / 4)^2 */
+  for (int i = 0; i < size; i++) {
+    s->window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (size - 1));
+  }
+
+  s->norm = 1.0f / ((size / 4.0f) * (size / 4.0f));
+
+  float ratio = max_freq / min_freq;
+
+  for (int i = 0; i < bars; i++) {
+    float lo_freq = min_freq * powf(ratio, (float)i / bars);
+    float hi_freq = min_freq * powf(ratio, (float)(i + 1) / bars);
+
+    int lo = lo_freq * size / sample_rate;
+    int hi = hi_freq * size / sample_rate;
+
+    lo = lo < bins - 1 ? lo : bins - 1;
+    hi = hi > lo ? hi : lo + 1;
+
+    s->bin_lo[i] = lo;
+    s->bin_hi[i] = hi < bins ? hi : bins;
+    s->levels[i] = SPECTRUM_MIN_DB;
+    s->peaks[i] = SPECTRUM_MIN_DB;
+  }
+
+  return s;
+}
+
+void spectrum_destroy(spectrum *s) {
+  if (s == NULL) return;
+
+  fft_destroy(s->fft);
+  free(s->window);
+  free(s->frame);
+  free(s->power);
+  free(s->bin_lo);
+  free(s->bin_hi);
+  free(s->levels);
+  free(s->peaks);
+  free(s);
+}
+
+/* moves the levels and peaks of `from` onto the bars of `s`, interpolated
+** at each bar's centre on the log frequency axis. bars outside the range
+** `from` covered start at the floor */
+void spectrum_carry(spectrum *s, const spectrum *from) {
+  float ratio = s->max_freq / s->min_freq;
+  float from_log = logf(from->max_freq / from->min_freq);
+
+  for (int i = 0; i < s->bars; i++) {
+    float freq = s->min_freq * powf(ratio, (i + 0.5f) / s->bars);
+    float at = logf(freq / from->min_freq) / from_log * from->bars - 0.5f;
+
+    if (at < -0.5f || at > from->bars - 0.5f) {
+      s->levels[i] = SPECTRUM_MIN_DB;
+      s->peaks[i] = SPECTRUM_MIN_DB;
+      continue;
+    }
+
+    at = at < 0 ? 0 : at > from->bars - 1 ? from->bars - 1 : at;
+
+    int j = at;
+    int k = j + 1 < from->bars ? j + 1 : j;
+    float t = at - j;
+
+    s->levels[i] = from->levels[j] + (from->levels[k] - from->levels[j]) * t;
+    s->peaks[i] = from->peaks[j] + (from->peaks[k] - from->peaks[j]) * t;
+  }
+}
+
+/* `samples` holds the latest `size` mono samples, `dt` the seconds since the last update */
+void spectrum_update(spectrum *s, const float *samples, float dt) {
+  for (int i = 0; i < s->size; i++) {
+    s->frame[i] = samples[i] * s->window[i];
+  }
+
+  fft_power(s->fft, s->frame, s->power);
+
+  float attack = 1.0f - expf(-dt / s->attack);
+  float decay = 1.0f - expf(-dt / s->decay);
+
+  for (int i = 0; i < s->bars; i++) {
+    float power = 0.0f;
+
+    for (int k = s->bin_lo[i]; k < s->bin_hi[i]; k++) {
+      power = s->power[k] > power ? s->power[k] : power;
+    }
+
+    power *= s->norm;
+
+    float target = power > 0.0f ? 10.0f * log10f(power) : SPECTRUM_MIN_DB;
+    target = target > SPECTRUM_MIN_DB ? target : SPECTRUM_MIN_DB;
+
+    float level = s->levels[i];
+    level += (target - level) * (target > level ? attack : decay);
+    s->levels[i] = level;
+
+    float peak_level = s->peaks[i] - s->peak_decay * dt;
+    s->peaks[i] = level > peak_level ? level : peak_level;
+  }
+}
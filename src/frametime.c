@@ -0,0 +1,109 @@
+#include <string.h>
+#include <stdatomic.h>
+
+#include <SDL2/SDL.h>
+
+#include <frametime.h>
+
+/*
+** the main thread fills in `current` and publishes it into the ring with a
+** release store of `ring_head`. readers never block it, they copy what they
+** want and drop whatever the writer may have overwritten meanwhile.
+*/
+
+const char *frametime_names[FRAMETIME_PHASES] = {
+  "events", "wait", "visualizer", "loudness", "player", "files", "queue",
+  "settings", "download", "overlay", "mu_end", "commands", "flush", "present"
+};
+
+static frametime_record ring[FRAMETIME_HISTORY];
+static atomic_uint ring_head;
+
+static bool enabled = false;
+static frametime_record current;
+static Uint64 stamp;
+static int sdl_allocations_before;
+
+void frametime_enable(bool on) {
+  enabled = on;
+}
+
+bool frametime_enabled(void) {
+  return enabled;
+}
+
+void frametime_begin(void) {
+  if (!enabled) { return; }
+
+  memset(&current, 0, sizeof(current));
+  sdl_allocations_before = SDL_GetNumAllocations();
+  stamp = SDL_GetPerformanceCounter();
+}
+
+/* charges the time since the last mark to `phase` */
+void frametime_mark(int phase) {
+  if (!enabled) { return; }
+
+  Uint64 now = SDL_GetPerformanceCounter();
+  current.ms[phase] += (now - stamp) * 1000.0 / SDL_GetPerformanceFrequency();
+  stamp = now;
+}
+
+frametime_record *frametime_current(void) {
+  return &current;
+}
+
+void frametime_end(void) {
+  if (!enabled) { return; }
+
+  current.total_ms = 0;
+  for (int i = 0; i < FRAMETIME_PHASES; i++) {
+    current.total_ms += current.ms[i];
+  }
+
+  current.sdl_allocations = SDL_GetNumAllocations() - sdl_allocations_before;
+
+  unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+  ring[head % FRAMETIME_HISTORY] = current;
+  atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+}
+
+/* copies up to `max` records, newest first, returns how many */
+int frametime_read(frametime_record *out, int max) {
+  unsigned head = atomic_load_explicit(&ring_head, memory_order_acquire);
+  int count = head < FRAMETIME_HISTORY ? head : FRAMETIME_HISTORY;
+
+  count = count < max ? count : max;
+
+  for (int i = 0; i < count; i++) {
+    out[i] = ring[(head - 1 - i) % FRAMETIME_HISTORY];
+  }
+
+  /* slots reused while copying belong to newer frames */
+  unsigned written = atomic_load_explicit(&ring_head, memory_order_acquire) - head;
+  int intact = written < FRAMETIME_HISTORY ? FRAMETIME_HISTORY - written : 0;
+
+  return count < intact ? count : intact;
+}
+
+/* tab separated, one frame per line, oldest first */
+bool frametime_dump(FILE *f) {
+  static frametime_record records[FRAMETIME_HISTORY];
+  int count = frametime_read(records, FRAMETIME_HISTORY);
+
+  fprintf(f, "frame\ttotal_ms");
+  for (int p = 0; p < FRAMETIME_PHASES; p++) fprintf(f, "\t%s_ms", frametime_names[p]);
+  fprintf(f, "\tdrawn\tquads\tbatches\tcommand_bytes\tcommand_peak\troot_peak\tcontainer_peak\tid_peak\tallocations\tsdl_allocations\n");
+
+  for (int i = count - 1; i >= 0; i--) {
+    const frametime_record *r = &records[i];
+
+    fprintf(f, "%d\t%.4f", count - 1 - i, r->total_ms);
+    for (int p = 0; p < FRAMETIME_PHASES; p++) fprintf(f, "\t%.4f", r->ms[p]);
+    fprintf(f, "\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n", r->drawn, r->quads, r->batches,
+      r->command_bytes, r->command_peak, r->root_peak, r->container_peak, r->id_peak,
+      r->allocations, r->sdl_allocations);
+  }
+
+  return !ferror(f);
+}
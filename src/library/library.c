@@ -0,0 +1,570 @@
+#include <stdio.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+#include <library.h>
+#include <waveform.h>
+#include <tempo.h>
+
+/* bumped whenever the files an entry points at change format, so they are rebuilt */
+#define INDEX_VERSION 2
+
+/* anything quieter than about -60 dBFS counts as silence */
+#define SILENCE_THRESHOLD 33
+#define SCAN_BLOCK 64
+
+/* write the index back every this many newly analysed tracks */
+#define SAVE_INTERVAL 16
+
+/* every analyser holds a whole decoded track, so keep the pool small */
+#define MAX_ANALYSERS 4
+
+static char index_path[1024];
+static char waveform_dir[1024];
+
+static library_entry *entries;
+static int entry_count = 0;
+static int entry_cap = 0;
+
+static int *slots;
+static int slot_cap = 0;
+
+static char **pending_dirs;
+static int pending_count = 0;
+
+/* files the walker found out of date, waiting for an analyser */
+static char **pending_files;
+static int pending_file_count = 0;
+static int busy = 0;
+
+static int dirty = 0;
+
+/* what save_index() writes out, owned by whoever holds `save_lock` */
+static library_entry *snapshot;
+static int snapshot_cap = 0;
+
+static SDL_mutex *lock;
+/* serialises index writes, taken before `lock` and never by the ui */
+static SDL_mutex *save_lock;
+static SDL_cond *wake;
+static SDL_cond *work;
+static SDL_Thread *worker;
+static SDL_Thread *analysers[MAX_ANALYSERS];
+static int analyser_count = 0;
+static SDL_atomic_t quit;
+
+/* bumped by library_cancel, work started under an older value is dropped */
+static SDL_atomic_t generation;
+
+static unsigned hash_path(const char *path) {
+  unsigned h = 2166136261;
+  while (*path) {
+    h = (h ^ (unsigned char)*path++) * 16777619;
+  }
+  return h;
+}
+
+static int find_slot(const char *path) {
+  if (slot_cap == 0) return -1;
+
+  unsigned i = hash_path(path) & (slot_cap - 1);
+
+  while (slots[i] != -1) {
+    if (strcmp(entries[slots[i]].path, path) == 0) {
+      return i;
+    }
+    i = (i + 1) & (slot_cap - 1);
+  }
+
+  return i;
+}
+
+static void rehash(void) {
+  slot_cap = slot_cap ? slot_cap * 2 : 256;
+  slots = realloc(slots, slot_cap * sizeof(int));
+
+  for (int i = 0; i < slot_cap; i++) {
+    slots[i] = -1;
+  }
+
+  for (int i = 0; i < entry_count; i++) {
+    slots[find_slot(entries[i].path)] = i;
+  }
+}
+
+/* caller holds `lock` */
+static void put_entry(const library_entry *entry) {
+  if ((entry_count + 1) * 2 > slot_cap) {
+    rehash();
+  }
+
+  int slot = find_slot(entry->path);
+
+  if (slots[slot] != -1) {
+    entries[slots[slot]] = *entry;
+    return;
+  }
+
+  if (entry_count == entry_cap) {
+    entry_cap = entry_cap ? entry_cap * 2 : 256;
+    entries = reallocarray(entries, entry_cap, sizeof(library_entry));
+  }
+
+  entries[entry_count] = *entry;
+  slots[slot] = entry_count;
+  entry_count++;
+}
+
+static void load_index(void) {
+  FILE *file = fopen(index_path, "r");
+
+  if (file == NULL) {
+    return;
+  }
+
+  char line[2048];
+  int version = 0;
+
+  if (fgets(line, sizeof(line), file) == NULL ||
+      sscanf(line, "sap-library %d", &version) != 1 || version != INDEX_VERSION) {
+    fclose(file);
+    return;
+  }
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    library_entry entry = { 0 };
+
+    char *tab = strchr(line, '\t');
+    if (tab == NULL) continue;
+    *tab = '\0';
+
+    strlcpy(entry.path, line, sizeof(entry.path));
+
+    /* the tempo fields were added later and may be missing */
+    if (sscanf(tab + 1, "%lld\t%lld\t%d\t%d\t%d\t%f\t%d",
+         &entry.mtime, &entry.size, &entry.flags,
+         &entry.lead_ms, &entry.trail_ms, &entry.bpm, &entry.beat_ms) < 5) {
+      continue;
+    }
+
+    put_entry(&entry);
+  }
+
+  fclose(file);
+}
+
+/* caller must not hold `lock`. the entries are copied under it and written
+** out after it is released, so library_lookup() never waits on the disk */
+static void save_index(void) {
+  SDL_LockMutex(save_lock);
+  SDL_LockMutex(lock);
+
+  int count = entry_count;
+
+  if (count > snapshot_cap) {
+    snapshot_cap = entry_cap;
+    snapshot = reallocarray(snapshot, snapshot_cap, sizeof(library_entry));
+  }
+
+  /* paths use a fraction of their buffer, only that part is copied */
+  size_t fields = offsetof(library_entry, mtime);
+
+  for (int i = 0; i < count; i++) {
+    memcpy(snapshot[i].path, entries[i].path, strlen(entries[i].path) + 1);
+    memcpy((char*)&snapshot[i] + fields, (char*)&entries[i] + fields, sizeof(library_entry) - fields);
+  }
+
+  dirty = 0;
+
+  SDL_UnlockMutex(lock);
+
+  char tmp_path[1040];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+
+  FILE *file = fopen(tmp_path, "w");
+
+  if (file != NULL) {
+    fprintf(file, "sap-library %d\n", INDEX_VERSION);
+
+    for (int i = 0; i < count; i++) {
+      library_entry *entry = &snapshot[i];
+
+      fprintf(file, "%s\t%lld\t%lld\t%d\t%d\t%d\t%.2f\t%d\n",
+        entry->path, entry->mtime, entry->size, entry->flags,
+        entry->lead_ms, entry->trail_ms, entry->bpm, entry->beat_ms);
+    }
+
+    fclose(file);
+    rename(tmp_path, index_path);
+  }
+
+  SDL_UnlockMutex(save_lock);
+}
+
+static int block_peak(const int16_t *samples, int count) {
+  int peak = 0;
+
+  /* branch free so the compiler turns it into packed abs/max */
+  for (int i = 0; i < count; i++) {
+    int value = samples[i] < 0 ? -samples[i] : samples[i];
+    peak = value > peak ? value : peak;
+  }
+
+  return peak;
+}
+
+static int first_loud(const int16_t *samples, int count) {
+  int i = 0;
+
+  for (; i + SCAN_BLOCK <= count; i += SCAN_BLOCK) {
+    if (block_peak(samples + i, SCAN_BLOCK) > SILENCE_THRESHOLD) break;
+  }
+
+  for (; i < count; i++) {
+    if (abs(samples[i]) > SILENCE_THRESHOLD) return i;
+  }
+
+  return -1;
+}
+
+static int last_loud(const int16_t *samples, int count) {
+  int i = count;
+
+  for (; i - SCAN_BLOCK >= 0; i -= SCAN_BLOCK) {
+    if (block_peak(samples + i - SCAN_BLOCK, SCAN_BLOCK) > SILENCE_THRESHOLD) break;
+  }
+
+  for (i--; i >= 0; i--) {
+    if (abs(samples[i]) > SILENCE_THRESHOLD) return i;
+  }
+
+  return -1;
+}
+
+static bool cancelled(void *data) {
+  return SDL_AtomicGet(&quit) || SDL_AtomicGet(&generation) != *(int*)data;
+}
+
+/* returns false when cancelled part way, `entry` is then incomplete */
+static bool analyse_track(library_entry *entry, int gen) {
+  int freq, channels;
+  Uint16 format;
+
+  entry->flags = LIBRARY_NOAUDIO;
+
+  if (Mix_QuerySpec(&freq, &format, &channels) == 0 || format != AUDIO_S16SYS) {
+    return true;
+  }
+
+  Mix_Chunk *chunk = Mix_LoadWAV(entry->path);
+
+  if (chunk == NULL) {
+    return true;
+  }
+
+  const int16_t *samples = (const int16_t*)chunk->abuf;
+  int count = chunk->alen / sizeof(int16_t);
+
+  int first = first_loud(samples, count);
+  int last = last_loud(samples, count);
+
+  entry->flags = LIBRARY_SILENCE;
+  entry->lead_ms = 0;
+  entry->trail_ms = 0;
+
+  if (first != -1) {
+    entry->lead_ms = (long long)(first / channels) * 1000 / freq;
+    entry->trail_ms = (long long)(last / channels + 1) * 1000 / freq;
+  }
+
+  char waveform_path[1024];
+
+  if (library_waveform_path(entry->path, waveform_path, sizeof(waveform_path)) &&
+      waveform_build(samples, count / channels, channels, entry->path, waveform_path)) {
+    entry->flags |= LIBRARY_WAVEFORM;
+  }
+
+  tempo_result tempo;
+  bool done = tempo_analyse(samples, count / channels, channels, freq, &tempo, cancelled, &gen);
+
+  if (done) {
+    entry->flags |= LIBRARY_TEMPO;
+    entry->bpm = tempo.bpm;
+    entry->beat_ms = tempo.beat_ms;
+  }
+
+  Mix_FreeChunk(chunk);
+
+  return done;
+}
+
+static void scan_file(const char *path, int gen) {
+  struct stat source_stat;
+
+  if (stat(path, &source_stat) == -1) {
+    return;
+  }
+
+  library_entry entry = { 0 };
+
+  SDL_LockMutex(lock);
+
+  int slot = find_slot(path);
+  if (slot != -1 && slots[slot] != -1) {
+    entry = entries[slots[slot]];
+  }
+
+  if ((entry.mtime != source_stat.st_mtime || entry.size != source_stat.st_size ||
+      !(entry.flags & LIBRARY_NOAUDIO || (entry.flags & LIBRARY_ANALYSED) == LIBRARY_ANALYSED)) &&
+      !cancelled(&gen)) {
+    pending_files = reallocarray(pending_files, pending_file_count + 1, sizeof(char *));
+    pending_files[pending_file_count++] = strdup(path);
+    SDL_CondSignal(work);
+  }
+
+  SDL_UnlockMutex(lock);
+}
+
+static void scan_dir(const char *dir_path, int gen) {
+  struct dirent *entry;
+
+  char abs_entry_name[1024];
+
+  DIR *dir = opendir(dir_path);
+
+  if (dir == NULL) {
+    return;
+  }
+
+  while ((entry = readdir(dir)) != NULL && !cancelled(&gen)) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+
+    snprintf(abs_entry_name, 1024, "%s/%s", dir_path, entry->d_name);
+
+    if (entry->d_type == DT_DIR) {
+      scan_dir(abs_entry_name, gen);
+    } else if (entry->d_type == DT_REG) {
+      scan_file(abs_entry_name, gen);
+    }
+  }
+
+  closedir(dir);
+}
+
+/* walks the queued directories and hands stale files to the analysers */
+static int worker_main(void *data) {
+  SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+  SDL_LockMutex(lock);
+
+  while (!SDL_AtomicGet(&quit)) {
+    if (pending_count == 0) {
+      SDL_CondWait(wake, lock);
+      continue;
+    }
+
+    char *dir = pending_dirs[--pending_count];
+    int gen = SDL_AtomicGet(&generation);
+
+    SDL_UnlockMutex(lock);
+    scan_dir(dir, gen);
+    free(dir);
+    SDL_LockMutex(lock);
+  }
+
+  SDL_UnlockMutex(lock);
+
+  return 0;
+}
+
+static int analyser_main(void *data) {
+  SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+  SDL_LockMutex(lock);
+
+  while (!SDL_AtomicGet(&quit)) {
+    if (pending_file_count == 0) {
+      if (busy == 0 && dirty > 0) {
+        SDL_UnlockMutex(lock);
+        save_index();
+        SDL_LockMutex(lock);
+        continue;
+      }
+
+      SDL_CondWait(work, lock);
+      continue;
+    }
+
+    char *path = pending_files[--pending_file_count];
+    int gen = SDL_AtomicGet(&generation);
+    busy++;
+
+    SDL_UnlockMutex(lock);
+
+    struct stat source_stat;
+    library_entry entry = { 0 };
+    bool done = false;
+
+    if (stat(path, &source_stat) == 0) {
+      strlcpy(entry.path, path, sizeof(entry.path));
+      entry.mtime = source_stat.st_mtime;
+      entry.size = source_stat.st_size;
+
+      done = analyse_track(&entry, gen);
+    }
+
+    free(path);
+
+    SDL_LockMutex(lock);
+
+    busy--;
+
+    if (done && !cancelled(&gen)) {
+      put_entry(&entry);
+      if (++dirty >= SAVE_INTERVAL) {
+        SDL_UnlockMutex(lock);
+        save_index();
+        SDL_LockMutex(lock);
+      }
+    }
+  }
+
+  SDL_UnlockMutex(lock);
+
+  return 0;
+}
+
+void library_init(const char *path) {
+  strlcpy(index_path, path, sizeof(index_path));
+
+  /* waveform overviews live next to the index */
+  char *slash = strrchr(index_path, '/');
+  int dir_len = slash ? slash - index_path : 0;
+
+  snprintf(waveform_dir, sizeof(waveform_dir), "%.*s/waveforms", dir_len, index_path);
+  mkdir(waveform_dir, 16877);
+
+  lock = SDL_CreateMutex();
+  save_lock = SDL_CreateMutex();
+  wake = SDL_CreateCond();
+  work = SDL_CreateCond();
+
+  load_index();
+
+  worker = SDL_CreateThread(worker_main, "library", NULL);
+
+  /* leave a core for playback and the ui */
+  analyser_count = SDL_GetCPUCount() - 1;
+  analyser_count = analyser_count < 1 ? 1 : analyser_count;
+  analyser_count = analyser_count > MAX_ANALYSERS ? MAX_ANALYSERS : analyser_count;
+
+  for (int i = 0; i < analyser_count; i++) {
+    analysers[i] = SDL_CreateThread(analyser_main, "analyser", NULL);
+  }
+}
+
+void library_add_dir(const char *dir) {
+  SDL_LockMutex(lock);
+
+  pending_dirs = reallocarray(pending_dirs, pending_count + 1, sizeof(char *));
+  pending_dirs[pending_count++] = strdup(dir);
+
+  SDL_CondSignal(wake);
+  SDL_UnlockMutex(lock);
+}
+
+bool library_lookup(const char *path, library_entry *entry) {
+  bool found = false;
+
+  SDL_LockMutex(lock);
+
+  int slot = find_slot(path);
+  if (slot != -1 && slots[slot] != -1) {
+    *entry = entries[slots[slot]];
+    found = true;
+  }
+
+  SDL_UnlockMutex(lock);
+
+  return found;
+}
+
+/* false when the cache directory is too deep for `len`, a cut path would
+** point at another file */
+bool library_waveform_path(const char *path, char *out, int len) {
+  return snprintf(out, len, "%s/%08x", waveform_dir, hash_path(path)) < len;
+}
+
+/* tracks queued or being analysed right now */
+int library_pending(void) {
+  SDL_LockMutex(lock);
+  int pending = pending_file_count + busy;
+  SDL_UnlockMutex(lock);
+
+  return pending;
+}
+
+/* drops all queued work and stops the tracks in flight, results so far are kept */
+void library_cancel(void) {
+  SDL_LockMutex(lock);
+
+  SDL_AtomicIncRef(&generation);
+
+  for (int i = 0; i < pending_count; i++) {
+    free(pending_dirs[i]);
+  }
+
+  for (int i = 0; i < pending_file_count; i++) {
+    free(pending_files[i]);
+  }
+
+  pending_count = 0;
+  pending_file_count = 0;
+
+  SDL_UnlockMutex(lock);
+}
+
+void library_shutdown(void) {
+  SDL_AtomicSet(&quit, 1);
+
+  SDL_LockMutex(lock);
+  SDL_CondSignal(wake);
+  SDL_CondBroadcast(work);
+  SDL_UnlockMutex(lock);
+
+  SDL_WaitThread(worker, NULL);
+
+  for (int i = 0; i < analyser_count; i++) {
+    SDL_WaitThread(analysers[i], NULL);
+  }
+
+  if (dirty > 0) {
+    save_index();
+  }
+
+  for (int i = 0; i < pending_count; i++) {
+    free(pending_dirs[i]);
+  }
+
+  for (int i = 0; i < pending_file_count; i++) {
+    free(pending_files[i]);
+  }
+
+  free(pending_dirs);
+  free(pending_files);
+  free(entries);
+  free(snapshot);
+  free(slots);
+
+  SDL_DestroyCond(wake);
+  SDL_DestroyCond(work);
+  SDL_DestroyMutex(lock);
+  SDL_DestroyMutex(save_lock);
+}
@@ -0,0 +1,206 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fft.h>
+#include <tempo.h>
+
+/*
+** onsets come from spectral flux: the summed rise of log magnitude between
+** consecutive fft frames. the tempo is the lag with the strongest
+** autocorrelation of that envelope, weighted towards 120 bpm to keep
+** half and double tempo guesses down, and the beat grid is the phase
+** whose comb of beats collects the most flux.
+*/
+
+#define FRAME_SIZE 1024
+#define HOP_SIZE 512
+
+#define MIN_BPM 60.0f
+#define MAX_BPM 200.0f
+
+/* frames of local mean taken off the envelope, about a quarter second */
+#define MEAN_FRAMES 21
+
+#define CANCEL_INTERVAL 256
+
+static float *onset_envelope(const int16_t *samples, int frames, int channels, int count,
+                             tempo_cancel cancelled, void *data) {
+  int bins = FRAME_SIZE / 2 + 1;
+
+  fft_plan *fft = fft_create(FRAME_SIZE);
+
+  float *window = malloc(FRAME_SIZE * sizeof(float));
+  float *frame = malloc(FRAME_SIZE * sizeof(float));
+  float *power = malloc(bins * sizeof(float));
+  float *previous = calloc(bins, sizeof(float));
+  float *flux = malloc(count * sizeof(float));
+
+  float scale = 1.0f / (32768.0f * channels);
+
+  for (int i = 0; i < FRAME_SIZE; i++) {
+    window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (FRAME_SIZE - 1));
+  }
+
+  for (int t = 0; t < count; t++) {
+    if (t % CANCEL_INTERVAL == 0 && cancelled != NULL && cancelled(data)) {
+      free(flux);
+      flux = NULL;
+      break;
+    }
+
+    const int16_t *start = samples + (long)t * HOP_SIZE * channels;
+
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      int sum = 0;
+      for (int c = 0; c < channels; c++) sum += start[i * channels + c];
+      frame[i] = sum * scale * window[i];
+    }
+
+    fft_power(fft, frame, power);
+
+    float rise = 0.0f;
+
+    /* log compression keeps loud low bins from drowning everything else */
+    for (int k = 1; k < bins; k++) {
+      float level = logf(1.0f + 1000.0f * sqrtf(power[k]));
+      float diff = level - previous[k];
+      rise += diff > 0.0f ? diff : 0.0f;
+      previous[k] = level;
+    }
+
+    flux[t] = t > 0 ? rise : 0.0f;
+  }
+
+  fft_destroy(fft);
+  free(window);
+  free(frame);
+  free(power);
+  free(previous);
+
+  return flux;
+}
+
+/* subtracts a running mean and keeps what rises above it */
+static void rectify(float *flux, int count) {
+  float *mean = malloc(count * sizeof(float));
+  float sum = 0.0f;
+
+  for (int t = 0; t < count + MEAN_FRAMES / 2; t++) {
+    if (t < count) sum += flux[t];
+    if (t >= MEAN_FRAMES) sum -= flux[t - MEAN_FRAMES];
+
+    int centre = t - MEAN_FRAMES / 2;
+    if (centre >= 0) {
+      int lo = t - MEAN_FRAMES + 1 > 0 ? t - MEAN_FRAMES + 1 : 0;
+      int hi = t < count ? t : count - 1;
+      mean[centre] = sum / (hi - lo + 1);
+    }
+  }
+
+  for (int t = 0; t < count; t++) {
+    float value = flux[t] - mean[t];
+    flux[t] = value > 0.0f ? value : 0.0f;
+  }
+
+  free(mean);
+}
+
+static float autocorrelation(const float *env, int count, int lag) {
+  float sum = 0.0f;
+  for (int t = lag; t < count; t++) {
+    sum += env[t] * env[t - lag];
+  }
+  return sum / (count - lag);
+}
+
+bool tempo_analyse(const int16_t *samples, int frames, int channels, int sample_rate,
+                   tempo_result *result, tempo_cancel cancelled, void *data) {
+  result->bpm = 0.0f;
+  result->beat_ms = 0;
+
+  int count = frames >= FRAME_SIZE ? (frames - FRAME_SIZE) / HOP_SIZE + 1 : 0;
+
+  float rate = (float)sample_rate / HOP_SIZE;
+  int min_lag = floorf(rate * 60.0f / MAX_BPM);
+  int max_lag = ceilf(rate * 60.0f / MIN_BPM);
+
+  /* too short for a handful of beats, there is nothing to find */
+  if (count < max_lag * 4) {
+    return true;
+  }
+
+  float *env = onset_envelope(samples, frames, channels, count, cancelled, data);
+
+  if (env == NULL) {
+    return false;
+  }
+
+  rectify(env, count);
+
+  float *scores = malloc((max_lag + 2) * sizeof(float));
+  int best = 0;
+
+  for (int lag = min_lag - 1; lag <= max_lag + 1; lag++) {
+    float bpm = rate * 60.0f / lag;
+    float octaves = log2f(bpm / 120.0f);
+
+    scores[lag - min_lag + 1] = autocorrelation(env, count, lag) * expf(-0.5f * octaves * octaves);
+
+    if (lag >= min_lag && lag <= max_lag &&
+        (best == 0 || scores[lag - min_lag + 1] > scores[best - min_lag + 1])) {
+      best = lag;
+    }
+  }
+
+  float peak = scores[best - min_lag + 1];
+
+  if (peak <= 0.0f) {
+    free(scores);
+    free(env);
+    return true;
+  }
+
+  /* parabolic fit through the neighbours for a sub-frame period */
+  float before = scores[best - min_lag];
+  float after = scores[best - min_lag + 2];
+  float curve = before - 2.0f * peak + after;
+  float period = best + (curve < 0.0f ? 0.5f * (before - after) / curve : 0.0f);
+
+  /* a small period error smears the comb over a whole track, so the
+  ** period is refined together with the phase */
+  float best_period = period;
+  int best_phase = 0;
+  float best_energy = -1.0f;
+
+  for (float candidate = period - 0.5f; candidate <= period + 0.5f; candidate += 0.02f) {
+    for (int phase = 0; phase < (int)candidate; phase++) {
+      float energy = 0.0f;
+      int beats = 0;
+
+      for (float t = phase; t < count; t += candidate) {
+        energy += env[(int)t];
+        beats++;
+      }
+
+      energy /= beats;
+
+      if (energy > best_energy) {
+        best_energy = energy;
+        best_phase = phase;
+        best_period = candidate;
+      }
+    }
+  }
+
+  period = best_period;
+
+  result->bpm = rate * 60.0f / period;
+  /* frame t is centred FRAME_SIZE / 2 samples after its start */
+  result->beat_ms = ((long long)best_phase * HOP_SIZE + FRAME_SIZE / 2) * 1000 / sample_rate;
+
+  free(scores);
+  free(env);
+
+  return true;
+}
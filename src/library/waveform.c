@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <waveform.h>
+
+/*
+** a cache file is the "SAPW" magic, a version, the length and bytes of the
+** track path, the frame count, the level count, the bucket count of every
+** level and then the min/max pairs of every level, finest first. each level
+** halves the previous one, down to a handful of buckets. cache files are
+** named by a hash of the track path, so the stored path tells a colliding
+** track's file apart from our own.
+*/
+
+#define WAVEFORM_VERSION 2
+#define MIN_BUCKETS 16
+#define MAX_LEVELS 32
+
+/* the bucket counts of every level for `frames` frames, returns the level count */
+static int waveform_counts(int frames, int *counts) {
+  int levels = 0;
+  int count = ((long)frames + WAVEFORM_BUCKET - 1) / WAVEFORM_BUCKET;
+
+  do {
+    counts[levels++] = count;
+    count = (count + 1) / 2;
+  } while (counts[levels - 1] > MIN_BUCKETS && levels < MAX_LEVELS);
+
+  return levels;
+}
+
+static waveform *waveform_alloc(int levels, const int *counts) {
+  waveform *wf = malloc(sizeof(waveform));
+
+  wf->levels = levels;
+  wf->counts = malloc(levels * sizeof(int));
+  wf->min = malloc(levels * sizeof(int8_t *));
+  wf->max = malloc(levels * sizeof(int8_t *));
+
+  for (int i = 0; i < levels; i++) {
+    wf->counts[i] = counts[i];
+    wf->min[i] = malloc(counts[i]);
+    wf->max[i] = malloc(counts[i]);
+  }
+
+  return wf;
+}
+
+void waveform_free(waveform *wf) {
+  if (wf == NULL) return;
+
+  for (int i = 0; i < wf->levels; i++) {
+    free(wf->min[i]);
+    free(wf->max[i]);
+  }
+
+  free(wf->counts);
+  free(wf->min);
+  free(wf->max);
+  free(wf);
+}
+
+static bool waveform_save(const waveform *wf, int frames, const char *track, const char *path) {
+  char tmp_path[1040];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  FILE *file = fopen(tmp_path, "wb");
+
+  if (file == NULL) {
+    return false;
+  }
+
+  int track_len = strlen(track);
+  int header[2] = { WAVEFORM_VERSION, track_len };
+  int sizes[2] = { frames, wf->levels };
+
+  fwrite("SAPW", 4, 1, file);
+  fwrite(header, sizeof(header), 1, file);
+  fwrite(track, 1, track_len, file);
+  fwrite(sizes, sizeof(sizes), 1, file);
+  fwrite(wf->counts, sizeof(int), wf->levels, file);
+
+  for (int i = 0; i < wf->levels; i++) {
+    fwrite(wf->min[i], 1, wf->counts[i], file);
+    fwrite(wf->max[i], 1, wf->counts[i], file);
+  }
+
+  bool ok = ferror(file) == 0;
+
+  fclose(file);
+
+  return ok && rename(tmp_path, path) == 0;
+}
+
+bool waveform_build(const int16_t *samples, int frames, int channels,
+                    const char *track, const char *path) {
+  int counts[MAX_LEVELS];
+
+  if (frames < 1) {
+    return false;
+  }
+
+  int levels = waveform_counts(frames, counts);
+
+  waveform *wf = waveform_alloc(levels, counts);
+
+  for (int b = 0; b < counts[0]; b++) {
+    const int16_t *p = samples + (long)b * WAVEFORM_BUCKET * channels;
+    int n = (b == counts[0] - 1 ? frames - b * WAVEFORM_BUCKET : WAVEFORM_BUCKET) * channels;
+
+    int lo = 0, hi = 0;
+
+    for (int i = 0; i < n; i++) {
+      lo = p[i] < lo ? p[i] : lo;
+      hi = p[i] > hi ? p[i] : hi;
+    }
+
+    wf->min[0][b] = lo >> 8;
+    wf->max[0][b] = hi >> 8;
+  }
+
+  for (int l = 1; l < levels; l++) {
+    for (int b = 0; b < counts[l]; b++) {
+      int a = 2 * b;
+      int c = 2 * b + 1 < counts[l - 1] ? 2 * b + 1 : a;
+
+      int8_t *min = wf->min[l - 1], *max = wf->max[l - 1];
+
+      wf->min[l][b] = min[a] < min[c] ? min[a] : min[c];
+      wf->max[l][b] = max[a] > max[c] ? max[a] : max[c];
+    }
+  }
+
+  bool ok = waveform_save(wf, frames, track, path);
+
+  waveform_free(wf);
+
+  return ok;
+}
+
+/* returns NULL unless `path` holds a well formed overview of `track` */
+waveform *waveform_load(const char *path, const char *track) {
+  FILE *file = fopen(path, "rb");
+
+  if (file == NULL) {
+    return NULL;
+  }
+
+  char magic[4];
+  int header[2];
+  char stored[1024];
+  int sizes[2];
+  int counts[MAX_LEVELS];
+  int expected[MAX_LEVELS];
+
+  int track_len = strlen(track);
+
+  if (fread(magic, 4, 1, file) != 1 || memcmp(magic, "SAPW", 4) != 0 ||
+      fread(header, sizeof(header), 1, file) != 1 || header[0] != WAVEFORM_VERSION ||
+      header[1] != track_len || track_len >= (int)sizeof(stored) ||
+      fread(stored, 1, track_len, file) != (size_t)track_len ||
+      memcmp(stored, track, track_len) != 0 ||
+      fread(sizes, sizeof(sizes), 1, file) != 1 ||
+      sizes[0] < 1 || sizes[1] < 1 || sizes[1] > MAX_LEVELS ||
+      fread(counts, sizeof(int), sizes[1], file) != (size_t)sizes[1]) {
+    fclose(file);
+    return NULL;
+  }
+
+  /* the counts follow from the frame count alone, so anything else is a
+  ** damaged file and must not size the allocations below */
+  int levels = waveform_counts(sizes[0], expected);
+
+  if (levels != sizes[1] || memcmp(counts, expected, levels * sizeof(int)) != 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  waveform *wf = waveform_alloc(levels, counts);
+
+  for (int i = 0; i < wf->levels; i++) {
+    if (fread(wf->min[i], 1, counts[i], file) != (size_t)counts[i] ||
+        fread(wf->max[i], 1, counts[i], file) != (size_t)counts[i]) {
+      waveform_free(wf);
+      wf = NULL;
+      break;
+    }
+  }
+
+  fclose(file);
+
+  return wf;
+}
+
+/* resamples the whole track to `columns` min/max pairs from the closest level */
+void waveform_columns(const waveform *wf, int columns, int8_t *min, int8_t *max) {
+  int level = 0;
+
+  while (level + 1 < wf->levels && wf->counts[level + 1] >= columns) {
+    level++;
+  }
+
+  int count = wf->counts[level];
+
+  for (int c = 0; c < columns; c++) {
+    int start = (long)c * count / columns;
+    int end = (long)(c + 1) * count / columns;
+
+    if (end <= start) end = start + 1;
+
+    int8_t lo = wf->min[level][start], hi = wf->max[level][start];
+
+    for (int b = start + 1; b < end; b++) {
+      lo = wf->min[level][b] < lo ? wf->min[level][b] : lo;
+      hi = wf->max[level][b] > hi ? wf->max[level][b] : hi;
+    }
+
+    min[c] = lo;
+    max[c] = hi;
+  }
+}
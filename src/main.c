@@ -11,9 +11,25 @@
 
 #include <microui.h>
 #include <renderer.h>
+#include <library.h>
+#include <analysis.h>
+#include <spectrum.h>
+#include <waveform.h>
+#include <frametime.h>
+#include <recording.h>
+#include <damage.h>
+#include <truncate.h>
 
 #define VISUALIZER_BARS 32
-#define MIN_DBFS (-98.09f)
+#define VISUALIZER_MIN_FREQ 40.0f
+
+/* longest wait for an event while nothing animates, keeps labels
+** such as the library progress current */
+#define IDLE_TIMEOUT_MS 250
+#define DEFAULT_REFRESH_RATE 60
+
+/* a retained files window still rereads its folders this often */
+#define FILES_RESCAN_MS 1000
 
 static int _argc = 0;
 static char **_argv;
@@ -27,16 +43,82 @@ static Mix_Music *music = NULL;
 static float music_pos = 0;
 static unsigned char volume = MIX_MAX_VOLUME;
 
-static float dBFS_data[VISUALIZER_BARS] = { MIN_DBFS };
+static Uint32 track_event;
+static Uint32 analysis_event;
+
+static float max_fps = 144;
+static int refresh_rate = DEFAULT_REFRESH_RATE;
+
+/* set when something outside the command list changed what is on screen */
+static bool force_redraw = true;
+
+/* SAP_HEADLESS=<frames> draws that many frames offscreen, uncapped, and
+** prints how long each took. SAP_HEADLESS_PNG saves the last one */
+static int headless_frames = 0;
+static int headless_done = 0;
+static const char *headless_png;
+static double (*headless_ms)[2];
+
+static int show_frametime = 0;
+
+/* how long each step from entering main to the first presented frame took,
+** shown with the frame stats and in the headless report */
+enum {
+  STARTUP_SDL,
+  STARTUP_RENDERER,
+  STARTUP_ANALYSIS,
+  STARTUP_LIBRARY,
+  STARTUP_FIRST_FRAME,
+  STARTUP_PHASES
+};
+
+static const char *startup_names[STARTUP_PHASES] = {
+  "SDL init", "Renderer", "Analysis", "Library", "First frame"
+};
+
+static double startup_ms[STARTUP_PHASES];
+static double startup_total_ms = 0;
+static Uint64 startup_last;
+
+/* SAP_RECORD=<path> writes every drawn frame's commands for sap-replay */
+static FILE *recording;
+static char frametime_path[1024];
+
+static analysis_config vis_config = {
+  VISUALIZER_BARS, VISUALIZER_MIN_FREQ, 0, 0.01f, 0.3f, 20.0f
+};
+static float vis_nyquist;
+static int vis_spectrogram = 0;
+
+static waveform *overview = NULL;
+static char overview_path[1024];
+static bool overview_tried = false;
+static int8_t *overview_min, *overview_max;
+static mu_Rect *overview_rects;
+static int overview_columns = 0;
 
 static char queue[1024][1024];
 static int queue_count = 0;
 static int queue_selected = 0;
 
 static int shuffle = 0;
+static int skip_silence = 0;
 
 static mu_Color color;
 
+static void play_music(const char *path) {
+    Mix_Music *previous = music;
+
+    music = Mix_LoadMUS(path);
+    Mix_PlayMusic(music, 1);
+
+    /* the new track has replaced it, so freeing cannot halt playback */
+    Mix_FreeMusic(previous);
+
+    /* integrated loudness is measured per track */
+    analysis_reset_loudness();
+}
+
 static void music_finished(void) {
     if (shuffle) {
       queue_selected = rand() % queue_count;
@@ -48,40 +130,23 @@ static void music_finished(void) {
       }
     }
 
-    music = Mix_LoadMUS(queue[queue_selected]);
-
-    Mix_PlayMusic(music, 1);
-}
-
-static void music_hook(void *udata, Uint8 *stream, int len) {
-  if (queue_count == 0) {
-      Mix_FreeMusic(music);
-      music = NULL;
-  }
-
-  int16_t *samples = (int16_t*)stream;
-
-  int total_sampels = len / sizeof(int16_t);
-
-  double sum_of_squares = 0.0;
+    play_music(queue[queue_selected]);
 
-  for (int i = 0; i < total_sampels; i++) {
-    float normalized_sample = (float)samples[i] / 32767.0f;
-
-    sum_of_squares = (double)normalized_sample * normalized_sample;
-  }
+    library_entry entry;
 
-  double avg_square = sum_of_squares / total_sampels;
-
-  float rms_amplitude = (float)sqrt(avg_square);
+    if (skip_silence && library_lookup(queue[queue_selected], &entry) && entry.lead_ms > 0) {
+      Mix_SetMusicPosition(entry.lead_ms / 1000.0);
+    }
+}
 
-  float rms_dBFS = rms_amplitude > 0.0f ? 20.0f * log10f(rms_amplitude) : MIN_DBFS;
-  
-  for (int i = 0; i < VISUALIZER_BARS - 1; i++) {
-     dBFS_data[i] = dBFS_data[i+1];
-  }
+/* runs on the audio thread, the track change is handled by the main loop */
+static void music_finished_hook(void) {
+  SDL_Event e = { .type = track_event };
+  SDL_PushEvent(&e);
+}
 
-  dBFS_data[VISUALIZER_BARS - 1] = rms_dBFS;
+static void music_hook(void *udata, Uint8 *stream, int len) {
+  analysis_push((int16_t*)stream, len / (2 * sizeof(int16_t)));
 }
 
 static int text_width(mu_Font font, const char *text, int len) {
@@ -116,19 +181,19 @@ static char *strip_file(char *entry) {
     return stripped_entry;
 }
 
-static void truncate_text(mu_Context *ctx, char *text) {
-    mu_Container *container =  mu_get_current_container(ctx);
-    int width = container->rect.w;
-  
-    for (int i = strlen(text); i > 0; i--) {
-      int t_width = text_width(NULL, text, -1) + 15;
-      
-      if (t_width > width) {
-        text[i] = '\0';
-      } else {
-        break;
-      }
-    }
+static uint64_t hash_text(const char *text, int len) {
+  uint64_t h = 14695981039346656037ULL;
+
+  for (int i = 0; i < len; i++) {
+    h = (h ^ (unsigned char)text[i]) * 1099511628211ULL;
+  }
+
+  return h;
+}
+
+/* folds what a window shows into the version it passes to mu_retain */
+static unsigned window_version(const int *state, int count) {
+  return hash_text((const char*)state, count * sizeof(int));
 }
 
 static void add_to_queue(const char *music_path) {
@@ -141,6 +206,31 @@ static void add_to_queue(const char *music_path) {
     }
 }
 
+/* tracks without a known tempo sort last */
+static int compare_tempo(const void *a, const void *b) {
+  library_entry entry;
+
+  float bpm_a = library_lookup(a, &entry) && entry.bpm > 0 ? entry.bpm : INFINITY;
+  float bpm_b = library_lookup(b, &entry) && entry.bpm > 0 ? entry.bpm : INFINITY;
+
+  return (bpm_a > bpm_b) - (bpm_a < bpm_b);
+}
+
+static void sort_queue_by_tempo(void) {
+  char playing[1024];
+
+  strlcpy(playing, queue[queue_selected], sizeof(playing));
+
+  qsort(queue, queue_count, sizeof(queue[0]), compare_tempo);
+
+  for (int i = 0; i < queue_count; i++) {
+    if (strcmp(queue[i], playing) == 0) {
+      queue_selected = i;
+      break;
+    }
+  }
+}
+
 static void remove_from_queue(char *music_path) {
     bool move_to_left = false;
 
@@ -164,8 +254,7 @@ static void remove_from_queue(char *music_path) {
       if (queue_selected == queue_count) {
         music_finished();
       } else {
-        music = Mix_LoadMUS(queue[queue_selected]);
-        Mix_PlayMusic(music, 1);
+        play_music(queue[queue_selected]);
       }
     } else if (removed_idx < queue_selected) {
       queue_selected--;
@@ -201,11 +290,11 @@ static void get_tracks(mu_Context *ctx, char *dir_path) {
               get_tracks(ctx, abs_entry_name);
           } else if (entry->d_type == DT_REG) {
              Mix_Music *temp_music = Mix_LoadMUS(abs_entry_name);
-             truncate_text(ctx, entry->d_name);
+             int name_width = truncate_text(ctx, entry->d_name);
              if (temp_music != NULL) {
                 bool duplicate = false;
              
-                mu_layout_row(ctx, 2, (int[]) { text_width(NULL, entry->d_name, -1) + 5, -1 }, 0);
+                mu_layout_row(ctx, 2, (int[]) { name_width + 5, -1 }, 0);
                 if (mu_button(ctx, entry->d_name) || add_dir) {
                 
                   for (int i = 0; i < queue_count; i++) {
@@ -230,12 +319,94 @@ static void get_tracks(mu_Context *ctx, char *dir_path) {
     closedir(dir);
 }
 
+static void load_overview(const char *path) {
+  if (strcmp(overview_path, path) != 0) {
+    waveform_free(overview);
+    overview = NULL;
+    overview_tried = false;
+    overview_columns = 0;
+    strlcpy(overview_path, path, 1024);
+  }
+
+  if (overview_tried) return;
+
+  library_entry entry;
+
+  /* the library worker may not have reached this track yet */
+  if (library_lookup(path, &entry) && entry.flags & LIBRARY_WAVEFORM) {
+    char waveform_path[1024];
+
+    if (library_waveform_path(path, waveform_path, 1024)) {
+      overview = waveform_load(waveform_path, path);
+    }
+
+    overview_tried = true;
+  }
+}
+
+static void draw_overview(mu_Context *ctx, mu_Rect rect, float progress) {
+  if (overview == NULL || rect.w <= 0) return;
+
+  if (overview_columns != rect.w) {
+    overview_min = realloc(overview_min, rect.w);
+    overview_max = realloc(overview_max, rect.w);
+    overview_rects = realloc(overview_rects, rect.w * sizeof(mu_Rect));
+    overview_columns = rect.w;
+
+    waveform_columns(overview, rect.w, overview_min, overview_max);
+  }
+
+  int half = rect.h / 2;
+  int middle = rect.y + half;
+  int played = mu_clamp((int)(progress * rect.w), 0, rect.w);
+
+  mu_Color upcoming = color;
+  upcoming.a /= 3;
+
+  for (int x = 0; x < rect.w; x++) {
+    int top = middle - overview_max[x] * half / 128;
+    int bottom = middle - overview_min[x] * half / 128;
+
+    overview_rects[x] = mu_rect(rect.x + x, top, 1, bottom - top + 1);
+  }
+
+  /* the columns left of the playhead in one batch, the rest in another */
+  mu_draw_quads(ctx, overview_rects, played, color);
+  mu_draw_quads(ctx, overview_rects + played, rect.w - played, upcoming);
+}
+
 static void player_window(mu_Context *ctx) {
   if (mu_begin_window_ex(ctx, "Player", mu_rect(44, 325, 348, 115), MU_OPT_NOCLOSE)) {
-      mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
-
       music_pos = Mix_GetMusicPosition(music);
 
+      if (skip_silence && music != NULL && queue_count > 0 && Mix_PausedMusic() == 0) {
+        library_entry entry;
+
+        if (library_lookup(queue[queue_selected], &entry) && entry.trail_ms > 0 &&
+            music_pos * 1000 >= entry.trail_ms) {
+          music_finished();
+        }
+      }
+
+      float duration = Mix_MusicDuration(music);
+
+      if (music != NULL && queue_count > 0) {
+        load_overview(queue[queue_selected]);
+      }
+
+      /* the slider shows the position to a hundredth of a second */
+      int state[] = {
+        queue_selected, queue_count, (int)(intptr_t)music, overview != NULL,
+        music_pos * 100, duration * 100, color.r, color.g, color.b, color.a
+      };
+
+      if (mu_retain(ctx, window_version(state, 10))) {
+        mu_end_window(ctx);
+        return;
+      }
+
+      mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+
       if (music != NULL && queue_count > 0) {
         char currently_plaing[2048];
         char *stripped_file = strip_file(queue[queue_selected]);
@@ -247,12 +418,27 @@ static void player_window(mu_Context *ctx) {
         
         free(stripped_file);
       }
-      
-      
-      if (mu_slider(ctx, &music_pos, 0, Mix_MusicDuration(music))) {
+
+      /* the waveform is drawn under a slider with a see-through base */
+      mu_Rect seek = mu_layout_next(ctx);
+      mu_layout_set_next(ctx, seek, 0);
+
+      mu_Color base[3];
+      memcpy(base, &ctx->style->colors[MU_COLOR_BASE], sizeof(base));
+
+      if (music != NULL && queue_count > 0 && overview != NULL) {
+        ctx->draw_frame(ctx, seek, MU_COLOR_BASE);
+        draw_overview(ctx, seek, duration > 0 ? music_pos / duration : 0);
+
+        for (int i = 0; i < 3; i++) ctx->style->colors[MU_COLOR_BASE + i].a = 0;
+      }
+
+      if (mu_slider(ctx, &music_pos, 0, duration)) {
         Mix_SetMusicPosition(music_pos);
       }
 
+      memcpy(&ctx->style->colors[MU_COLOR_BASE], base, sizeof(base));
+
       if (ctx->key_pressed == MU_KEY_RIGHT || ctx->key_pressed == MU_KEY_LEFT) {
          int music_duration = Mix_MusicDuration(music);
          float jump = ctx->key_down == (MU_KEY_SHIFT | ctx->key_pressed) ? 10 : 5; 
@@ -281,8 +467,7 @@ static void player_window(mu_Context *ctx) {
           queue_selected = 0;
         }
         
-        music = Mix_LoadMUS(queue[queue_selected]);
-        Mix_PlayMusic(music, 1);
+        play_music(queue[queue_selected]);
       }
       
       if (mu_button(ctx, "||") || ctx->key_pressed == MU_KEY_SPACE) {
@@ -310,36 +495,133 @@ static void player_window(mu_Context *ctx) {
 static void visualizer_window(mu_Context *ctx) {
    if (mu_begin_window(ctx, "Visualizer", mu_rect(60, 60, VISUALIZER_BARS * 10, 200))) {
       mu_Container *win = mu_get_current_container(ctx);
- 
+
+      const analysis_frame *frame = analysis_latest();
+
+      char meter_text[64];
+
+      mu_layout_row(ctx, 2, (int[]) { 150, -1 }, 0);
+
+      for (int c = 0; c < METER_CHANNELS; c++) {
+        snprintf(meter_text, 64, "%c %.1f / %.1f dB (%d)", c == 0 ? 'L' : 'R',
+          frame->rms_db[c], frame->peak_db[c], frame->clipped[c]);
+        mu_label(ctx, meter_text);
+      }
+
+      if (vis_spectrogram) {
+        static unsigned last_serial = 0;
+
+        /* one column per analysis frame the ui gets to see */
+        if (frame->serial != last_serial) {
+          sdlr_push_spectrogram_column(frame->levels, frame->bars, SPECTRUM_MIN_DB);
+          last_serial = frame->serial;
+          damage_add(win->rect);
+        }
+
+        snprintf(meter_text, 64, "upload %.3f ms", sdlr_get_stats()->upload_ms);
+        mu_label(ctx, meter_text);
+
+        mu_layout_row(ctx, 1, (int[]) { -1 }, -1);
+        mu_draw_icon(ctx, SDLR_ICON_SPECTROGRAM, mu_layout_next(ctx), color);
+
+        mu_end_window(ctx);
+        return;
+      }
+
+      mu_Rect bars[ANALYSIS_MAX_BARS];
+      mu_Rect peaks[ANALYSIS_MAX_BARS];
+
       int x = win->rect.x;
       int y = win->rect.y;
 
-      int width = win->rect.w / VISUALIZER_BARS;
+      int width = win->rect.w;
       int height = win->rect.h;
-      
-      for (int i = 0; i < VISUALIZER_BARS; i++) {
-        float dBFS = dBFS_data[i];
 
-        float dBFS_percent = (dBFS + -MIN_DBFS) / -MIN_DBFS;
+      /* bar edges are spread over the current window width, so resizing
+      ** the window never leaves a gap on the right */
+      for (int i = 0; i < frame->bars; i++) {
+        int left = x + i * width / frame->bars;
+        int right = x + (i + 1) * width / frame->bars - 1;
 
-        int bar_y = height + y - (height * dBFS_percent);
+        float dB_percent = (frame->levels[i] - SPECTRUM_MIN_DB) / -SPECTRUM_MIN_DB;
+        float peak_percent = (frame->peaks[i] - SPECTRUM_MIN_DB) / -SPECTRUM_MIN_DB;
 
-        mu_Rect rect = mu_rect(x, bar_y, width, height * dBFS_percent);
-        x += width; 
+        int bar_height = height * dB_percent;
+        int peak_y = height + y - (int)(height * peak_percent);
 
-       mu_draw_box(ctx, rect, color);
+        bars[i] = mu_rect(left, height + y - bar_height, right - left, bar_height);
+        peaks[i] = mu_rect(left, peak_y, right - left, 2);
       }
 
+      /* flash the bars on the beat grid found by the library */
+      mu_Color bar_color = color;
+      library_entry entry;
+
+      if (music != NULL && queue_count > 0 && Mix_PausedMusic() == 0 &&
+          library_lookup(queue[queue_selected], &entry) && entry.bpm > 0) {
+        float beats = (music_pos - entry.beat_ms / 1000.0f) * entry.bpm / 60.0f;
+        float pulse = 0.5f * expf(-6.0f * (beats - floorf(beats)));
+
+        bar_color.r += (255 - bar_color.r) * pulse;
+        bar_color.g += (255 - bar_color.g) * pulse;
+        bar_color.b += (255 - bar_color.b) * pulse;
+      }
+
+      mu_draw_quads(ctx, bars, frame->bars, bar_color);
+      mu_draw_quads(ctx, peaks, frame->bars, ctx->style->colors[MU_COLOR_TEXT]);
+
       mu_end_window(ctx);
    }
 }
 
+static void loudness_window(mu_Context *ctx) {
+  if (mu_begin_window(ctx, "Loudness", mu_rect(426, 590, 300, 100))) {
+    const analysis_frame *frame = analysis_latest();
+
+    const char *names[] = { "Momentary", "Short-term", "Integrated", "True peak" };
+    float values[] = {
+      frame->momentary_lufs, frame->short_term_lufs, frame->integrated_lufs, frame->true_peak_db
+    };
+
+    char value_text[32];
+
+    mu_layout_row(ctx, 4, (int[]) { 70, 70, 70, -1 }, 0);
+
+    for (int i = 0; i < 4; i++) {
+      if (isinf(values[i])) {
+        snprintf(value_text, 32, "-");
+      } else {
+        snprintf(value_text, 32, "%.1f %s", values[i], i == 3 ? "dBTP" : "LUFS");
+      }
+
+      mu_label(ctx, names[i]);
+      mu_label(ctx, value_text);
+    }
+
+    mu_layout_row(ctx, 1, (int[]) { 70 }, 0);
+
+    if (mu_button(ctx, "Reset")) {
+      analysis_reset_loudness();
+    }
+
+    mu_end_window(ctx);
+  }
+}
+
 static void files_window(mu_Context *ctx) {
   struct stat source_stat;
    
   char path[1024];
 
   if (mu_begin_window_ex(ctx, "Files", mu_rect(426, 40, 300, 200), MU_OPT_NOCLOSE)) {
+    /* walking the folders opens every track, so it is skipped while the
+    ** window is left alone, apart from picking up new files now and then */
+    int state[] = { drag_and_drop_count, SDL_GetTicks() / FILES_RESCAN_MS };
+
+    if (mu_retain(ctx, window_version(state, 2))) {
+      mu_end_window(ctx);
+      return;
+    }
 
     mu_layout_row(ctx, 1, (int[]) { -1 }, -25);
 
@@ -389,8 +671,7 @@ static void queue_window(mu_Context *ctx) {
       
       if (mu_button(ctx, stripped_file)) { 
           queue_selected = i;
-          music = Mix_LoadMUS(queue[queue_selected]);
-          Mix_PlayMusic(music, 1);  
+          play_music(queue[queue_selected]);
       };
       
       free(stripped_file);
@@ -398,7 +679,7 @@ static void queue_window(mu_Context *ctx) {
    
     mu_end_panel(ctx);
     
-    mu_layout_row(ctx, 3, (int[]) { 86, 30, 50 }, -1);
+    mu_layout_row(ctx, 3, (int[]) { 86, 80, -1 }, -1);
     if (mu_button(ctx, "Clear")) {
       queue_selected = 0;
       queue_count = 0;
@@ -406,6 +687,10 @@ static void queue_window(mu_Context *ctx) {
 
     mu_checkbox(ctx, "Shuffle", &shuffle);
 
+    if (mu_button(ctx, "Sort by tempo") && queue_count > 0) {
+      sort_queue_by_tempo();
+    }
+
     mu_end_window(ctx);
   }
 }
@@ -469,8 +754,22 @@ static int uint8_slider(mu_Context *ctx, unsigned char *value, int low, int high
   return res;
 }
 
+static int setting_slider(mu_Context *ctx, const char *label, float *value, float low, float high, float step, const char *fmt) {
+  mu_label(ctx, label);
+  return mu_slider_ex(ctx, value, low, high, step, fmt, MU_OPT_ALIGNCENTER);
+}
+
 static void settings_window(mu_Context *ctx) {
-  if (mu_begin_window_ex(ctx, "Settings", mu_rect(100, 470, 241, 168), MU_OPT_NOCLOSE)) {
+  if (mu_begin_window_ex(ctx, "Settings", mu_rect(100, 470, 241, 192), MU_OPT_NOCLOSE)) {
+    /* everything else here only changes through its own controls */
+    int pending = library_pending();
+    int state[] = { pending, volume };
+
+    if (mu_retain(ctx, window_version(state, 2))) {
+      mu_end_window(ctx);
+      return;
+    }
+
     mu_layout_row(ctx, 2, (int[]) { 70, 150 }, 0);
     mu_label(ctx, "Volume");
 
@@ -489,20 +788,235 @@ static void settings_window(mu_Context *ctx) {
     mu_label(ctx, "Vis B"); uint8_slider(ctx, &color.b, 0, 255);
     mu_label(ctx, "Vis A"); uint8_slider(ctx, &color.a, 0, 255);
 
+    mu_label(ctx, "Silence"); mu_checkbox(ctx, "Skip", &skip_silence);
+    mu_label(ctx, "Debug");
+
+    if (mu_checkbox(ctx, "Frame stats", &show_frametime) & MU_RES_CHANGE) {
+      frametime_enable(show_frametime);
+    }
+
+    setting_slider(ctx, "Max FPS", &max_fps, 10, 240, 1, "%.0f");
+
+    mu_label(ctx, "Library");
+
+    if (pending > 0) {
+      char stop_text[64];
+      snprintf(stop_text, 64, "Stop analysis (%d)", pending);
+
+      if (mu_button(ctx, stop_text)) {
+        library_cancel();
+      }
+    } else {
+      mu_label(ctx, "Up to date");
+    }
+
+    if (mu_header(ctx, "Visualizer")) {
+      static float bars;
+      int res = 0;
+
+      bars = vis_config.bars;
+
+      mu_layout_row(ctx, 2, (int[]) { 70, 150 }, 0);
+      res |= setting_slider(ctx, "Bars", &bars, 4, ANALYSIS_MAX_BARS, 1, "%.0f");
+      res |= setting_slider(ctx, "Low Hz", &vis_config.min_freq, 20, 1000, 10, "%.0f");
+      res |= setting_slider(ctx, "High Hz", &vis_config.max_freq, 1000, vis_nyquist, 100, "%.0f");
+      res |= setting_slider(ctx, "Attack", &vis_config.attack, 0.001f, 0.2f, 0, "%.3f s");
+      res |= setting_slider(ctx, "Decay", &vis_config.decay, 0.01f, 2.0f, 0, "%.2f s");
+      res |= setting_slider(ctx, "Peak fall", &vis_config.peak_decay, 0, 120, 1, "%.0f dB/s");
+      mu_label(ctx, "Mode"); mu_checkbox(ctx, "Spectrogram", &vis_spectrogram);
+
+      vis_config.bars = bars;
+
+      if (res & MU_RES_CHANGE) {
+        analysis_configure(&vis_config);
+      }
+    }
+
     mu_end_window(ctx);
   }
 }
 
 
+static void update_refresh_rate(void) {
+  refresh_rate = sdlr_get_refresh_rate();
+  refresh_rate = refresh_rate > 0 ? refresh_rate : DEFAULT_REFRESH_RATE;
+}
+
+/* playback moves the seek bar and meters, a held button may be dragging */
+static bool animating(mu_Context *ctx) {
+  return (music != NULL && Mix_PlayingMusic() && !Mix_PausedMusic()) || ctx->mouse_down;
+}
+
+static void startup_mark(int phase) {
+  Uint64 now = SDL_GetPerformanceCounter();
+
+  startup_ms[phase] = (now - startup_last) * 1000.0 / SDL_GetPerformanceFrequency();
+  startup_total_ms += startup_ms[phase];
+  startup_last = now;
+}
+
+static void frametime_window(mu_Context *ctx) {
+  static frametime_record records[FRAMETIME_HISTORY];
+
+  if (!show_frametime) { return; }
+
+  if (mu_begin_window_ex(ctx, "Frame stats", mu_rect(60, 60, 300, 380), MU_OPT_NOCLOSE)) {
+    int count = frametime_read(records, FRAMETIME_HISTORY);
+    char text[64];
+
+    if (count == 0) {
+      mu_end_window(ctx);
+      return;
+    }
+
+    /* recent frame totals as bars, newest on the right, 16.7 ms at the top */
+    mu_layout_row(ctx, 1, (int[]) { -1 }, 50);
+    mu_Rect graph = mu_layout_next(ctx);
+    mu_Rect bars[FRAMETIME_HISTORY];
+    int shown = mu_min(count, graph.w / 2);
+
+    for (int i = 0; i < shown; i++) {
+      int h = mu_min(graph.h, records[i].total_ms / 16.7f * graph.h);
+      bars[i] = mu_rect(graph.x + graph.w - (i + 1) * 2, graph.y + graph.h - h, 1, h);
+    }
+
+    mu_draw_quads(ctx, bars, shown, color);
+
+    /* per phase, the latest frame next to the mean and worst of the history */
+    float mean[FRAMETIME_PHASES + 1] = { 0 }, worst[FRAMETIME_PHASES + 1] = { 0 };
+
+    for (int i = 0; i < count; i++) {
+      for (int p = 0; p <= FRAMETIME_PHASES; p++) {
+        float ms = p < FRAMETIME_PHASES ? records[i].ms[p] : records[i].total_ms;
+        mean[p] += ms / count;
+        worst[p] = mu_max(worst[p], ms);
+      }
+    }
+
+    mu_layout_row(ctx, 4, (int[]) { 80, 60, 60, -1 }, 0);
+    mu_label(ctx, "ms"); mu_label(ctx, "last"); mu_label(ctx, "mean"); mu_label(ctx, "max");
+
+    for (int p = 0; p <= FRAMETIME_PHASES; p++) {
+      mu_label(ctx, p < FRAMETIME_PHASES ? frametime_names[p] : "total");
+      snprintf(text, 64, "%.3f", p < FRAMETIME_PHASES ? records[0].ms[p] : records[0].total_ms);
+      mu_label(ctx, text);
+      snprintf(text, 64, "%.3f", mean[p]);
+      mu_label(ctx, text);
+      snprintf(text, 64, "%.3f", worst[p]);
+      mu_label(ctx, text);
+    }
+
+    mu_layout_row(ctx, 2, (int[]) { 80, -1 }, 0);
+
+    mu_label(ctx, "Quads");
+    snprintf(text, 64, "%d in %d batches", records[0].quads, records[0].batches);
+    mu_label(ctx, text);
+
+    mu_label(ctx, "Commands");
+    snprintf(text, 64, "%d bytes, peak %d", records[0].command_bytes, records[0].command_peak);
+    mu_label(ctx, text);
+
+    mu_label(ctx, "Stack peaks");
+    snprintf(text, 64, "%d roots, %d containers, %d ids",
+      records[0].root_peak, records[0].container_peak, records[0].id_peak);
+    mu_label(ctx, text);
+
+    mu_label(ctx, "Allocations");
+    snprintf(text, 64, "%d, SDL live %+d", records[0].allocations, records[0].sdl_allocations);
+    mu_label(ctx, text);
+
+    mu_label(ctx, "Startup");
+    snprintf(text, 64, "%.1f ms", startup_total_ms);
+    mu_label(ctx, text);
+
+    for (int p = 0; p < STARTUP_PHASES; p++) {
+      mu_label(ctx, startup_names[p]);
+      snprintf(text, 64, "%.3f ms", startup_ms[p]);
+      mu_label(ctx, text);
+    }
+
+    if (mu_button(ctx, "Dump")) {
+      FILE *f = fopen(frametime_path, "w");
+
+      if (f == NULL || !frametime_dump(f)) {
+        fprintf(stderr, "sap: could not write %s\n", frametime_path);
+      }
+
+      if (f != NULL) fclose(f);
+    }
+
+    mu_label(ctx, frametime_path);
+
+    mu_end_window(ctx);
+  }
+}
+
 static void process_frame(mu_Context *ctx) {
   mu_begin(ctx);
   visualizer_window(ctx);
+  frametime_mark(FRAMETIME_VISUALIZER);
+  loudness_window(ctx);
+  frametime_mark(FRAMETIME_LOUDNESS);
   player_window(ctx);
+  frametime_mark(FRAMETIME_PLAYER);
   files_window(ctx);
+  frametime_mark(FRAMETIME_FILES);
   queue_window(ctx);
+  frametime_mark(FRAMETIME_QUEUE);
   settings_window(ctx);
+  frametime_mark(FRAMETIME_SETTINGS);
   download_window(ctx);
+  frametime_mark(FRAMETIME_DOWNLOAD);
+  frametime_window(ctx);
+  frametime_mark(FRAMETIME_OVERLAY);
   mu_end(ctx);
+  frametime_mark(FRAMETIME_MU_END);
+}
+
+static int compare_ms(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+
+  return (x > y) - (x < y);
+}
+
+static void headless_report(void) {
+  double *total = malloc(headless_frames * sizeof(double));
+  double sum = 0;
+
+  printf("# frame ui_ms render_ms\n");
+
+  for (int i = 0; i < headless_frames; i++) {
+    printf("%d %.3f %.3f\n", i, headless_ms[i][0], headless_ms[i][1]);
+    total[i] = headless_ms[i][0] + headless_ms[i][1];
+    sum += total[i];
+  }
+
+  qsort(total, headless_frames, sizeof(double), compare_ms);
+
+  printf("# %d frames, mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+    headless_frames, sum / headless_frames, total[headless_frames / 2],
+    total[headless_frames * 99 / 100], total[headless_frames - 1]);
+
+  printf("# startup %.3f ms:", startup_total_ms);
+
+  for (int p = 0; p < STARTUP_PHASES; p++) {
+    printf(" %s %.3f%s", startup_names[p], startup_ms[p], p + 1 < STARTUP_PHASES ? "," : "\n");
+  }
+
+  free(total);
+}
+
+/* records a frame, the last one quits through the usual path */
+static void headless_frame(double ui_ms, double render_ms) {
+  headless_ms[headless_done][0] = ui_ms;
+  headless_ms[headless_done][1] = render_ms;
+
+  if (++headless_done == headless_frames) {
+    headless_report();
+
+    SDL_Event quit = { .type = SDL_QUIT };
+    SDL_PushEvent(&quit);
+  }
 }
 
 static const char button_map[256] = {
@@ -529,14 +1043,57 @@ static const short key_map[256] = {
 int main(int argc, char **argv) {
   struct stat source_stat;
 
+  char path[1024];
+
+  startup_last = SDL_GetPerformanceCounter();
+
+  const char *headless = getenv("SAP_HEADLESS");
+
+  if (headless != NULL) {
+    headless_frames = atoi(headless) > 0 ? atoi(headless) : 1;
+    headless_png = getenv("SAP_HEADLESS_PNG");
+    headless_ms = malloc(headless_frames * sizeof(headless_ms[0]));
+
+    /* no display or sound card needed unless a driver is asked for */
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+  }
+
+  const char *record_path = getenv("SAP_RECORD");
+
+  if (record_path != NULL) {
+    recording = fopen(record_path, "wb");
+
+    if (recording == NULL || !recording_write_header(recording)) {
+      fprintf(stderr, "sap: could not record to %s\n", record_path);
+      recording = NULL;
+    }
+  }
+
   SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
   Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024);
-  Mix_HookMusicFinished(music_finished);
+  track_event = SDL_RegisterEvents(1);
+  Mix_HookMusicFinished(music_finished_hook);
   Mix_SetPostMix(music_hook, NULL);
+  startup_mark(STARTUP_SDL);
+
   sdlr_init();
+  startup_mark(STARTUP_RENDERER);
+
+  int freq;
+  Mix_QuerySpec(&freq, NULL, NULL);
+  /* the analyzer sees the output decimated by two */
+  vis_nyquist = freq / 4.0f;
+  vis_config.max_freq = vis_nyquist;
+  analysis_event = SDL_RegisterEvents(1);
+  analysis_init(freq, &vis_config, analysis_event);
+  startup_mark(STARTUP_ANALYSIS);
+
+  /* every expanded folder keeps a tree node, so deep libraries need many */
+  const char *treenodes = getenv("SAP_TREENODES");
 
   mu_Context *ctx = malloc(sizeof(mu_Context));
-  mu_init(ctx);
+  mu_init_ex(ctx, MU_CONTAINERPOOL_SIZE, treenodes != NULL ? mu_max(atoi(treenodes), 1) : 4096);
   ctx->text_width = text_width;
   ctx->text_height = text_height;
 
@@ -567,13 +1124,72 @@ int main(int argc, char **argv) {
     mkdir(music_dir, 16877);
   }
 
+  char index_path[1024];
+
+  snprintf(index_path, 1024, "%s/.cache", pw->pw_dir);
+  mkdir(index_path, 16877);
+  snprintf(index_path, 1024, "%s/.cache/sap", pw->pw_dir);
+  mkdir(index_path, 16877);
+  snprintf(index_path, 1024, "%s/.cache/sap/library", pw->pw_dir);
+  snprintf(frametime_path, 1024, "%s/.cache/sap/frametime.tsv", pw->pw_dir);
+
+  library_init(index_path);
+  library_add_dir(music_dir);
+
+  for (int i = 1; i < argc; i++) {
+    if (stat(argv[i], &source_stat) == 0 && S_ISDIR(source_stat.st_mode)) {
+      realpath(argv[i], path);
+      library_add_dir(path);
+    }
+  }
+
   drag_and_drop_dirs = malloc(sizeof(char*));
- 
+  startup_mark(STARTUP_LIBRARY);
+
+  update_refresh_rate();
+
+  /* the scripted queue plays so the visualizers have something to draw */
+  if (headless_frames > 0 && queue_count > 0) {
+    play_music(queue[queue_selected]);
+  }
+
+  Uint32 last_frame = 0;
+
   for (;;) {
+    int fps = refresh_rate < max_fps ? refresh_rate : max_fps;
+    Uint32 period = headless_frames > 0 ? 0 : 1000 / fps;
+    Uint32 since = SDL_GetTicks() - last_frame;
+
+    /* sleep until the next frame is due, or until something happens. present
+    ** still waits for vsync, but unchanged frames never reach it, so this
+    ** wait is what keeps an idle loop from spinning */
+    int timeout = animating(ctx) || headless_frames > 0 ? (since < period ? period - since : 0) : IDLE_TIMEOUT_MS;
+
     SDL_Event e;
-    while (SDL_PollEvent(&e)) {
+    int got = SDL_WaitEventTimeout(&e, timeout);
+
+    /* the wait for the first event is idle time, not part of the frame */
+    frametime_begin();
+
+    for (; got; got = SDL_PollEvent(&e)) {
+      if (e.type == track_event) {
+        if (queue_count > 0) music_finished();
+        continue;
+      }
+
       switch (e.type) {
+        case SDL_WINDOWEVENT:
+          update_refresh_rate();
+          force_redraw = true;
+          break;
+
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+          force_redraw = true;
+          break;
+
         case SDL_QUIT:
+          mu_free(ctx);
           free(ctx);
 
           for (int i = 0; i < drag_and_drop_count; i++) {
@@ -582,6 +1198,14 @@ int main(int argc, char **argv) {
           
           free(drag_and_drop_dirs);
 
+          Mix_SetPostMix(NULL, NULL);
+          Mix_HookMusicFinished(NULL);
+
+          analysis_shutdown();
+          library_shutdown();
+
+          if (recording != NULL) fclose(recording);
+
           Mix_FreeMusic(music);
           exit(EXIT_SUCCESS); 
           break;
@@ -621,6 +1245,8 @@ int main(int argc, char **argv) {
             drag_and_drop_dirs[drag_and_drop_count - 1] = malloc((strlen(e.drop.file) + 1) * sizeof(char));
                         
             strlcpy(drag_and_drop_dirs[drag_and_drop_count - 1], e.drop.file, strlen(e.drop.file) + 1);
+
+            library_add_dir(e.drop.file);
           }
           
           SDL_free(e.drop.file);
@@ -628,19 +1254,97 @@ int main(int argc, char **argv) {
       }
     }
 
+    if (queue_count == 0 && music != NULL) {
+      Mix_FreeMusic(music);
+      music = NULL;
+    }
+
+    frametime_mark(FRAMETIME_EVENTS);
+
+    /* input can arrive faster than the cap, it is batched into the next frame */
+    since = SDL_GetTicks() - last_frame;
+    if (since < period) {
+      SDL_Delay(period - since);
+    }
+
+    last_frame = SDL_GetTicks();
+    frametime_mark(FRAMETIME_WAIT);
+
+    /* quitting, the last headless frame is already out */
+    if (headless_frames > 0 && headless_done == headless_frames) {
+      continue;
+    }
+
+    Uint64 frame_start = SDL_GetPerformanceCounter();
+
+    recording_input input;
+    if (recording != NULL) recording_capture_input(ctx, &input);
+
     process_frame(ctx);
 
-    sdlr_clear(mu_color(10, 10, 23, 255));
-    mu_Command *cmd = NULL;
-    while (mu_next_command(ctx, &cmd)) {
-      switch (cmd->type) {
-        case MU_COMMAND_TEXT: sdlr_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color); break;
-        case MU_COMMAND_RECT: sdlr_draw_rect(cmd->rect.rect, cmd->rect.color); break;
-        case MU_COMMAND_ICON: sdlr_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
-        case MU_COMMAND_CLIP: sdlr_set_clip_rect(cmd->clip.rect); break;
+    Uint64 ui_end = SDL_GetPerformanceCounter();
+
+    mu_Rect damage[DAMAGE_MAX_RECTS];
+    int damage_count = damage_update(ctx, damage);
+
+    frametime_record *record = frametime_current();
+    record->command_bytes = ctx->command_list.idx;
+    record->command_peak = ctx->command_list.peak;
+    record->root_peak = ctx->root_list.peak;
+    record->container_peak = ctx->container_stack.peak;
+    record->id_peak = ctx->id_stack.peak;
+
+    if (force_redraw) {
+      damage[0] = mu_rect(0, 0, 0x1000000, 0x1000000);
+      damage_count = 1;
+    } else if (damage_count == 0 && headless_frames == 0) {
+      frametime_end();
+      continue;
+    }
+
+    force_redraw = false;
+
+    if (recording != NULL && !recording_write_frame(recording, &input, damage, damage_count, ctx)) {
+      fprintf(stderr, "sap: recording stopped, write failed\n");
+      fclose(recording);
+      recording = NULL;
+    }
+
+    /* each damaged area is cleared and gets every command reaching into it,
+    ** the rest of the window keeps what was drawn before */
+    for (int i = 0; i < damage_count; i++) {
+      sdlr_set_damage(damage[i]);
+      sdlr_clear(mu_color(10, 10, 23, 255));
+
+      mu_Command *cmd = NULL;
+      while (mu_next_command(ctx, &cmd)) {
+        sdlr_draw_command(cmd);
       }
     }
+
+    frametime_mark(FRAMETIME_COMMANDS);
+
+    if (headless_png != NULL && headless_done + 1 == headless_frames && !sdlr_save_png(headless_png)) {
+      fprintf(stderr, "sap: could not write %s\n", headless_png);
+    }
+
+    sdlr_flush();
+    frametime_mark(FRAMETIME_FLUSH);
     sdlr_present();
+    frametime_mark(FRAMETIME_PRESENT);
+
+    if (startup_ms[STARTUP_FIRST_FRAME] == 0) startup_mark(STARTUP_FIRST_FRAME);
+
+    record->drawn = true;
+    record->quads = sdlr_get_stats()->quads;
+    record->batches = sdlr_get_stats()->batches;
+    record->allocations = sdlr_get_stats()->allocations;
+    frametime_end();
+
+    if (headless_frames > 0) {
+      double freq = SDL_GetPerformanceFrequency() / 1000.0;
+      headless_frame((ui_end - frame_start) / freq, (SDL_GetPerformanceCounter() - ui_end) / freq);
+    }
   }
 
   return 0;
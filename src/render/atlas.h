@@ -1,138 +1,4 @@
 enum { ATLAS_WHITE = MU_ICON_MAX, ATLAS_FONT };
-enum { ATLAS_WIDTH = 128, ATLAS_HEIGHT = 128 };
-
-
-static char atlas_texture[ATLAS_WIDTH][ATLAS_HEIGHT] = {
-  "                                                                                                                                ",
-  "                                                   **                                                                           ",
-  "                                                   **    ***                                                                    ",
-  "               *           **    **  **   ** **   ****  ** **     ***      **       **    **                                    ",
-  "              ***         ****   **  **   ** **  **  ** ** ** *  ** **     **      **      **                                   ",
-  "             ***          ****   **  **  ******* **      *** **  ** **     **      **      **     ** **    **                   ",
-  "            ***           ****            ** **   **        **    ***             **        **     ***     **                   ",
-  "           ***             **             ** **    **      **    **               **        **   ******* ******          ****** ",
-  "  *       ***              **             ** **     **    **     ** ****          **        **     ***     **                   ",
-  " ***     ***                             *******     **  ** ***  **  **           **        **    ** **    **                   ",
-  "  ***   ***                **             ** **  **  **  * ** ** **  **           **        **                     ***          ",
-  "   *** ***                 **             ** **   ****     ** **  *** **           **      **                      ***          ",
-  "    *****                                          **       ***                    **      **                       **          ",
-  "     ***                                           **                               **    **                       **           ",
-  "      *                                                                                                                         ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "             **    ****     **    ****    ****    **     ******    ***   ******   ****    ****                       **         ",
-  "             **   **  **   ***   **  **  **  **   **     **        **        **  **  **  **  **                     **          ",
-  "            **    ** ***  ****   **  **  **  **   ** **  **       **        **   **  **  **  **    ***     ***     **           ",
-  "            **    ** ***    **       **      **   ** **  **      *****      **   *** **  **  **    ***     ***    **     ****** ",
-  "           **     **  **    **      **     ***    ** **  *****   **  **    **     ****   **  **                  **             ",
-  "           **     *** **    **     **        **  **  **      **  **  **    **    ** ***   *****                   **     ****** ",
-  "          **      *** **    **    **     **  **  *******     **  **  **   **     **  **     **                     **           ",
-  "   ***    **      **  **    **   **      **  **      **     **   **  **   **     **  **    **      ***     ***      **          ",
-  "   ***   **        ****     **   ******   ****       **  ****     ****    **      ****    ***      ***     ***       **         ",
-  "         **                                                                                                 **                  ",
-  "                                                                                                           **                   ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  " **       ****   ******    **    *****    ****   ****    ******  ******   ****   **  **   ****       **  **  **  **      **   **",
-  "  **     **  ** **    **  ****   **  **  **  **  ** **   **      **      **  **  **  **    **        **  **  **  **      **   **",
-  "   **    **  ** **    ** **  **  **  **  **  **  **  **  **      **      **  **  **  **    **        **  ** **   **      *** ***",
-  "    **      **  **  **** **  **  **  **  **      **  **  **      **      **      **  **    **        **  ** **   **      ** * **",
-  "     **    **   ** ** ** **  **  *****   **      **  **  *****   *****   **      ******    **        **  ****    **      ** * **",
-  "    **     **   ** ** ** ******  **  **  **      **  **  **      **      ** ***  **  **    **        **  ** **   **      ** * **",
-  "   **           **  **** **  **  **  **  **  **  **  **  **      **      **  **  **  **    **    **  **  ** **   **      **   **",
-  "  **       **   **       **  **  **  **  **  **  ** **   **      **      **  **  **  **    **    **  **  **  **  **      **   **",
-  " **        **    ******* **  **  *****    ****   ****    ******  **       *****  **  **   ****    ****   **  **  ******  **   **",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  " **   **  ****   *****    ****   *****    ****   ******  **  **  **  **  **   ** **  **  **  **  ******   ****   **       ****  ",
-  " **   ** **  **  **  **  **  **  **  **  **  **    **    **  **  **  **  **   ** **  **  **  **      **   **     **         **  ",
-  " ***  ** **  **  **  **  **  **  **  **  **        **    **  **  **  **  **   **  ** *   **  **      **   **      **        **  ",
-  " **** ** **  **  **  **  **  **  **  **   **       **    **  **  **  **  ** * **   **    **  **     **    **      **        **  ",
-  " ** **** **  **  *****   **  **  *****     **      **    **  **  **  **  ** * **   **     ****     **     **       **       **  ",
-  " **  *** **  **  **      **  **  ** **      **     **    **  **  **  **  ** * **  * **     **     **      **       **       **  ",
-  " **   ** **  **  **      **  **  **  **      **    **    **  **  **  **   ** **  **  **    **    **       **        **      **  ",
-  " **   ** **  **  **      **  **  **  **  **  **    **    **  **   ****    ** **  **  **    **    **       **        **      **  ",
-  " **   **  ****   **       ****   **  **   ****     **     ****     **     ** **  **  **    **    ******   **         **     **  ",
-  "                            **                                                                            **         **     **  ",
-  "                             **                                                                           **                **  ",
-  "                                                                                                          ****            ****  ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "   **             ***                                                                                                           ",
-  "  ****             **                                                                      **       **                          ",
-  " **  **             **           **                  **            ****          **        **       **   **      ****           ",
-  "                                 **                  **           **             **                      **        **           ",
-  "                          ****   *****    ****    *****   ****    **      *****  *****   ****     ****   **  **    **    ****** ",
-  "                             **  **  **  **  **  **  **  **  **   **     **  **  **  **    **       **   **  **    **    ** * **",
-  "                             **  **  **  **      **  **  **  **  ******  **  **  **  **    **       **   ** **     **    ** * **",
-  "                          *****  **  **  **      **  **  ******   **     **  **  **  **    **       **   ****      **    ** * **",
-  "                         **  **  **  **  **      **  **  **       **     **  **  **  **    **       **   ** **     **    ** * **",
-  "                         **  **  **  **  **  **  **  **  **       **     **  **  **  **    **       **   **  **    **    ** * **",
-  "                          *****  *****    ****    *****   ****    **      *****  **  **  ******     **   **  **  ******  **   **",
-  "                                                                             **                     **                          ",
-  "                                                                             **                     **                          ",
-  "        ********                                                         *****                   ****                           ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                  **                                                        **     **     **    ",
-  "                                                  **                                                       **      **      **   ",
-  " *****    ****   *****    *****  **  **   *****  ******  **  **  **  **  **   ** **  **  **  **  ******    **      **      **   ",
-  " **  **  **  **  **  **  **  **  ** ***  **       **     **  **  **  **  ** * ** **  **  **  **      **    **      **      **   ",
-  " **  **  **  **  **  **  **  **  ***     **       **     **  **  **  **  ** * **  ****   **  **     **    **       **       **  ",
-  " **  **  **  **  **  **  **  **  **       ****    **     **  **  **  **  ** * **   **    **  **    **    **        **        ** ",
-  " **  **  **  **  **  **  **  **  **          **   **     **  **  **  **  ** * **  ****   **  **   **      **       **       **  ",
-  " **  **  **  **  **  **  **  **  **          **   **     **  **   ****    ** **  **  **  **  **  **        **      **      **   ",
-  " **  **   ****   *****    *****  **      *****     ****   *****    **     ** **  **  **   ****   ******    **      **      **   ",
-  "                 **          **                                                             **             **      **      **   ",
-  "                 **          **                                                            **               **     **     **    ",
-  "                 **          **                                                         ****                       **           ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                        *         *                                                                             ",
-  " ***   * ******  **   **   ** *       * **       **                                                                             ",
-  "** ** ** ******  ***  *** *** **     **  **     **                                                                              ",
-  "*   ***  ******   ***  *****   **   **    **   **                                                                               ",
-  "         ******    ***  ***     ** **      ** **                                                                                ",
-  "         ******   ***    *       ***        ***                                                                                 ",
-  "         ******  ***              *         ***                                                                                 ",
-  "         ******  **                        ** **                                                                                ",
-  "         ******                           **   **                                                                               ",
-  "         ******                          **     **                                                                              ",
-  "                                        **       **                                                                             ",
-  "                                        *         *                                                                             ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                ",
-  "                                                                                                                                "
-};
-
 
 static mu_Rect atlas[] = {
   [ MU_ICON_CLOSE ] = {  40, 98, 11, 13 },
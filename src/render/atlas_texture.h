@@ -0,0 +1,132 @@
+/* the font and icon atlas as drawn, only read by atlasgen */
+
+static const char atlas_texture[128][128] = {
+  "                                                                                                                                ",
+  "                                                   **                                                                           ",
+  "                                                   **    ***                                                                    ",
+  "               *           **    **  **   ** **   ****  ** **     ***      **       **    **                                    ",
+  "              ***         ****   **  **   ** **  **  ** ** ** *  ** **     **      **      **                                   ",
+  "             ***          ****   **  **  ******* **      *** **  ** **     **      **      **     ** **    **                   ",
+  "            ***           ****            ** **   **        **    ***             **        **     ***     **                   ",
+  "           ***             **             ** **    **      **    **               **        **   ******* ******          ****** ",
+  "  *       ***              **             ** **     **    **     ** ****          **        **     ***     **                   ",
+  " ***     ***                             *******     **  ** ***  **  **           **        **    ** **    **                   ",
+  "  ***   ***                **             ** **  **  **  * ** ** **  **           **        **                     ***          ",
+  "   *** ***                 **             ** **   ****     ** **  *** **           **      **                      ***          ",
+  "    *****                                          **       ***                    **      **                       **          ",
+  "     ***                                           **                               **    **                       **           ",
+  "      *                                                                                                                         ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "             **    ****     **    ****    ****    **     ******    ***   ******   ****    ****                       **         ",
+  "             **   **  **   ***   **  **  **  **   **     **        **        **  **  **  **  **                     **          ",
+  "            **    ** ***  ****   **  **  **  **   ** **  **       **        **   **  **  **  **    ***     ***     **           ",
+  "            **    ** ***    **       **      **   ** **  **      *****      **   *** **  **  **    ***     ***    **     ****** ",
+  "           **     **  **    **      **     ***    ** **  *****   **  **    **     ****   **  **                  **             ",
+  "           **     *** **    **     **        **  **  **      **  **  **    **    ** ***   *****                   **     ****** ",
+  "          **      *** **    **    **     **  **  *******     **  **  **   **     **  **     **                     **           ",
+  "   ***    **      **  **    **   **      **  **      **     **   **  **   **     **  **    **      ***     ***      **          ",
+  "   ***   **        ****     **   ******   ****       **  ****     ****    **      ****    ***      ***     ***       **         ",
+  "         **                                                                                                 **                  ",
+  "                                                                                                           **                   ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  " **       ****   ******    **    *****    ****   ****    ******  ******   ****   **  **   ****       **  **  **  **      **   **",
+  "  **     **  ** **    **  ****   **  **  **  **  ** **   **      **      **  **  **  **    **        **  **  **  **      **   **",
+  "   **    **  ** **    ** **  **  **  **  **  **  **  **  **      **      **  **  **  **    **        **  ** **   **      *** ***",
+  "    **      **  **  **** **  **  **  **  **      **  **  **      **      **      **  **    **        **  ** **   **      ** * **",
+  "     **    **   ** ** ** **  **  *****   **      **  **  *****   *****   **      ******    **        **  ****    **      ** * **",
+  "    **     **   ** ** ** ******  **  **  **      **  **  **      **      ** ***  **  **    **        **  ** **   **      ** * **",
+  "   **           **  **** **  **  **  **  **  **  **  **  **      **      **  **  **  **    **    **  **  ** **   **      **   **",
+  "  **       **   **       **  **  **  **  **  **  ** **   **      **      **  **  **  **    **    **  **  **  **  **      **   **",
+  " **        **    ******* **  **  *****    ****   ****    ******  **       *****  **  **   ****    ****   **  **  ******  **   **",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  " **   **  ****   *****    ****   *****    ****   ******  **  **  **  **  **   ** **  **  **  **  ******   ****   **       ****  ",
+  " **   ** **  **  **  **  **  **  **  **  **  **    **    **  **  **  **  **   ** **  **  **  **      **   **     **         **  ",
+  " ***  ** **  **  **  **  **  **  **  **  **        **    **  **  **  **  **   **  ** *   **  **      **   **      **        **  ",
+  " **** ** **  **  **  **  **  **  **  **   **       **    **  **  **  **  ** * **   **    **  **     **    **      **        **  ",
+  " ** **** **  **  *****   **  **  *****     **      **    **  **  **  **  ** * **   **     ****     **     **       **       **  ",
+  " **  *** **  **  **      **  **  ** **      **     **    **  **  **  **  ** * **  * **     **     **      **       **       **  ",
+  " **   ** **  **  **      **  **  **  **      **    **    **  **  **  **   ** **  **  **    **    **       **        **      **  ",
+  " **   ** **  **  **      **  **  **  **  **  **    **    **  **   ****    ** **  **  **    **    **       **        **      **  ",
+  " **   **  ****   **       ****   **  **   ****     **     ****     **     ** **  **  **    **    ******   **         **     **  ",
+  "                            **                                                                            **         **     **  ",
+  "                             **                                                                           **                **  ",
+  "                                                                                                          ****            ****  ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "   **             ***                                                                                                           ",
+  "  ****             **                                                                      **       **                          ",
+  " **  **             **           **                  **            ****          **        **       **   **      ****           ",
+  "                                 **                  **           **             **                      **        **           ",
+  "                          ****   *****    ****    *****   ****    **      *****  *****   ****     ****   **  **    **    ****** ",
+  "                             **  **  **  **  **  **  **  **  **   **     **  **  **  **    **       **   **  **    **    ** * **",
+  "                             **  **  **  **      **  **  **  **  ******  **  **  **  **    **       **   ** **     **    ** * **",
+  "                          *****  **  **  **      **  **  ******   **     **  **  **  **    **       **   ****      **    ** * **",
+  "                         **  **  **  **  **      **  **  **       **     **  **  **  **    **       **   ** **     **    ** * **",
+  "                         **  **  **  **  **  **  **  **  **       **     **  **  **  **    **       **   **  **    **    ** * **",
+  "                          *****  *****    ****    *****   ****    **      *****  **  **  ******     **   **  **  ******  **   **",
+  "                                                                             **                     **                          ",
+  "                                                                             **                     **                          ",
+  "        ********                                                         *****                   ****                           ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                  **                                                        **     **     **    ",
+  "                                                  **                                                       **      **      **   ",
+  " *****    ****   *****    *****  **  **   *****  ******  **  **  **  **  **   ** **  **  **  **  ******    **      **      **   ",
+  " **  **  **  **  **  **  **  **  ** ***  **       **     **  **  **  **  ** * ** **  **  **  **      **    **      **      **   ",
+  " **  **  **  **  **  **  **  **  ***     **       **     **  **  **  **  ** * **  ****   **  **     **    **       **       **  ",
+  " **  **  **  **  **  **  **  **  **       ****    **     **  **  **  **  ** * **   **    **  **    **    **        **        ** ",
+  " **  **  **  **  **  **  **  **  **          **   **     **  **  **  **  ** * **  ****   **  **   **      **       **       **  ",
+  " **  **  **  **  **  **  **  **  **          **   **     **  **   ****    ** **  **  **  **  **  **        **      **      **   ",
+  " **  **   ****   *****    *****  **      *****     ****   *****    **     ** **  **  **   ****   ******    **      **      **   ",
+  "                 **          **                                                             **             **      **      **   ",
+  "                 **          **                                                            **               **     **     **    ",
+  "                 **          **                                                         ****                       **           ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                        *         *                                                                             ",
+  " ***   * ******  **   **   ** *       * **       **                                                                             ",
+  "** ** ** ******  ***  *** *** **     **  **     **                                                                              ",
+  "*   ***  ******   ***  *****   **   **    **   **                                                                               ",
+  "         ******    ***  ***     ** **      ** **                                                                                ",
+  "         ******   ***    *       ***        ***                                                                                 ",
+  "         ******  ***              *         ***                                                                                 ",
+  "         ******  **                        ** **                                                                                ",
+  "         ******                           **   **                                                                               ",
+  "         ******                          **     **                                                                              ",
+  "                                        **       **                                                                             ",
+  "                                        *         *                                                                             ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                ",
+  "                                                                                                                                "
+};
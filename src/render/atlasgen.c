@@ -0,0 +1,72 @@
+#include <stdio.h>
+
+#include "atlas_texture.h"
+
+/*
+** turns the ascii art atlas into rgba pixels at build time. '*' is white,
+** its 8 neighbours become a black outline, everything else is transparent.
+** the result is written as a c header holding the pixels and their size.
+*/
+
+enum {
+  HEIGHT = sizeof(atlas_texture) / sizeof(atlas_texture[0]),
+  WIDTH = sizeof(atlas_texture[0])
+};
+
+static unsigned char coverage[HEIGHT][WIDTH];
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s output.h\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 0; i < HEIGHT; i++) {
+    for (int j = 0; j < WIDTH; j++) {
+      if (atlas_texture[i][j] != '*') continue;
+
+      coverage[i][j] = 1;
+
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          int ny = i + dy;
+          int nx = j + dx;
+
+          if (ny >= 0 && nx >= 0 && ny < HEIGHT && nx < WIDTH && coverage[ny][nx] == 0) {
+            coverage[ny][nx] = 2;
+          }
+        }
+      }
+    }
+  }
+
+  FILE *out = fopen(argv[1], "w");
+
+  if (out == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out, "/* generated by atlasgen from atlas_texture.h */\n\n");
+  fprintf(out, "enum { ATLAS_WIDTH = %d, ATLAS_HEIGHT = %d };\n\n", WIDTH, HEIGHT);
+  fprintf(out, "static const unsigned char atlas_rgba[ATLAS_WIDTH * ATLAS_HEIGHT * 4] = {\n");
+
+  for (int i = 0; i < HEIGHT; i++) {
+    for (int j = 0; j < WIDTH; j++) {
+      unsigned char c = coverage[i][j] == 1 ? 255 : 0;
+      unsigned char a = coverage[i][j] != 0 ? 255 : 0;
+
+      fprintf(out, "%s%d,%d,%d,%d,", j % 8 == 0 ? "  " : "", c, c, c, a);
+      if (j % 8 == 7) fputc('\n', out);
+    }
+  }
+
+  fprintf(out, "};\n");
+
+  if (fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <damage.h>
+
+/*
+** every root container's commands are hashed once per frame. a container
+** whose hash, rect or stacking changed damages where it is now and where it
+** was, one that is gone damages where it was. jumps are left out, they
+** hold addresses that shift whenever an earlier container grows.
+*/
+
+typedef struct {
+  mu_Container *cnt;
+  unsigned long long hash;
+  mu_Rect rect;
+  int zindex;
+} root_state;
+
+/* the previous frame's roots, and room for this frame's, as many as the
+** root list has ever held */
+static root_state *last, *now;
+static bool *matched;
+static int last_count = 0, capacity = 0;
+
+/* changed outside the command list, e.g. a streamed texture */
+static mu_Rect pending;
+
+static bool is_empty(mu_Rect r) {
+  return r.w <= 0 || r.h <= 0;
+}
+
+static mu_Rect merge(mu_Rect a, mu_Rect b) {
+  if (is_empty(a)) { return b; }
+  if (is_empty(b)) { return a; }
+
+  int x = mu_min(a.x, b.x), y = mu_min(a.y, b.y);
+  int x2 = mu_max(a.x + a.w, b.x + b.w), y2 = mu_max(a.y + a.h, b.y + b.h);
+
+  return mu_rect(x, y, x2 - x, y2 - y);
+}
+
+static unsigned long long hash_bytes(unsigned long long h, const void *data, size_t len) {
+  const unsigned char *p = data;
+
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ p[i]) * 1099511628211ULL;
+  }
+
+  return h;
+}
+
+/* nested roots sit inside their parent's range, so they count for it too */
+static unsigned long long hash_root(mu_Container *cnt) {
+  unsigned long long h = 14695981039346656037ULL;
+  mu_Command *cmd = (mu_Command*)((char*)cnt->head + cnt->head->base.size);
+
+  while (cmd != cnt->tail) {
+    if (cmd->type == MU_COMMAND_TEXT) {
+      /* the padding after the string is never written */
+      h = hash_bytes(h, cmd, offsetof(mu_TextCommand, str) + strlen(cmd->text.str));
+    } else if (cmd->type != MU_COMMAND_JUMP) {
+      h = hash_bytes(h, cmd, cmd->base.size);
+    }
+
+    cmd = (mu_Command*)((char*)cmd + cmd->base.size);
+  }
+
+  return h;
+}
+
+static bool overlaps(mu_Rect a, mu_Rect b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+/* overlapping areas are merged so nothing is drawn twice, past
+** DAMAGE_MAX_RECTS the last one takes in the rest */
+static void add_rect(mu_Rect *rects, int *count, mu_Rect r) {
+  if (is_empty(r)) { return; }
+
+  for (int i = 0; i < *count; i++) {
+    if (overlaps(rects[i], r)) {
+      r = merge(r, rects[i]);
+      rects[i] = rects[--*count];
+      /* the grown rect may reach ones already passed */
+      i = -1;
+    }
+  }
+
+  if (*count < DAMAGE_MAX_RECTS) {
+    rects[(*count)++] = r;
+  } else {
+    rects[*count - 1] = merge(rects[*count - 1], r);
+  }
+}
+
+/* call after mu_end, fills `rects` with up to DAMAGE_MAX_RECTS areas that
+** changed since the last call and returns how many */
+int damage_update(mu_Context *ctx, mu_Rect *rects) {
+  int count = ctx->root_list.idx;
+  int damaged = 0;
+
+  if (count > capacity) {
+    capacity = ctx->root_list.cap;
+    last = realloc(last, capacity * sizeof(root_state));
+    now = realloc(now, capacity * sizeof(root_state));
+    matched = realloc(matched, capacity * sizeof(bool));
+  }
+
+  memset(matched, 0, last_count * sizeof(bool));
+
+  add_rect(rects, &damaged, pending);
+  pending = mu_rect(0, 0, 0, 0);
+
+  for (int i = 0; i < count; i++) {
+    mu_Container *cnt = ctx->root_list.items[i];
+    now[i] = (root_state) { cnt, hash_root(cnt), cnt->rect, cnt->zindex };
+
+    int j = 0;
+    while (j < last_count && last[j].cnt != cnt) j++;
+
+    if (j == last_count) {
+      add_rect(rects, &damaged, now[i].rect);
+      continue;
+    }
+
+    matched[j] = true;
+
+    if (last[j].hash != now[i].hash || last[j].zindex != now[i].zindex ||
+        memcmp(&last[j].rect, &now[i].rect, sizeof(mu_Rect)) != 0) {
+      add_rect(rects, &damaged, last[j].rect);
+      add_rect(rects, &damaged, now[i].rect);
+    }
+  }
+
+  for (int j = 0; j < last_count; j++) {
+    if (!matched[j]) add_rect(rects, &damaged, last[j].rect);
+  }
+
+  root_state *swap = last;
+  last = now;
+  now = swap;
+  last_count = count;
+
+  return damaged;
+}
+
+void damage_add(mu_Rect rect) {
+  pending = merge(pending, rect);
+}
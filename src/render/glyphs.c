@@ -0,0 +1,363 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include <glyphs.h>
+
+/*
+** glyphs outside the built-in ascii atlas are rasterised with SDL_ttf the
+** first time they are drawn and packed into the free part of the atlas by
+** a skyline packer. a skyline cannot free single rects, so when the atlas
+** is full every glyph not drawn in the current or previous frame is
+** dropped and the survivors are packed again from scratch. that moves
+** them, so the generation is bumped and cached geometry has to be rebuilt.
+** changed pixels are collected into one dirty rect for the renderer.
+*/
+
+#define MAX_FONTS 4
+#define MAX_SEGMENTS 256
+#define BUCKETS 1024
+
+enum { PLACED, MISSING, FULL };
+
+typedef struct {
+  int x, y, w;
+} segment;
+
+static const char *font_paths[] = {
+  "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+  "/usr/share/fonts/TTF/DejaVuSans.ttf",
+  "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+  "/usr/local/share/fonts/dejavu/DejaVuSans.ttf",
+  "/usr/share/fonts/noto/NotoSans-Regular.ttf",
+  "/usr/share/fonts/truetype/noto/NotoSans-Regular.ttf",
+  "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+  "/usr/share/fonts/noto-cjk/NotoSansCJK-Regular.ttc",
+  "/usr/local/share/fonts/noto/NotoSansCJK-Regular.ttc"
+};
+
+static TTF_Font *fonts[MAX_FONTS];
+static int font_count = 0;
+
+static unsigned char *atlas;
+static int reserved_width, reserved_height;
+static int glyph_height;
+
+static segment skyline[MAX_SEGMENTS];
+static int segment_count = 0;
+
+static glyph glyph_table[GLYPH_CAPACITY];
+static int glyph_count = 0;
+static int buckets[BUCKETS];
+
+static SDL_Rect dirty;
+static bool is_dirty = false;
+
+static unsigned generation = 0;
+static unsigned rasterized = 0;
+
+static void open_font(const char *path) {
+  if (font_count == MAX_FONTS) return;
+
+  /* the largest size that still fits the height of the ascii glyphs */
+  for (int size = 13; size >= 6; size--) {
+    TTF_Font *font = TTF_OpenFont(path, size);
+
+    if (font == NULL) return;
+
+    if (TTF_FontHeight(font) <= glyph_height) {
+      fonts[font_count++] = font;
+      return;
+    }
+
+    TTF_CloseFont(font);
+  }
+}
+
+static void mark_dirty(SDL_Rect rect) {
+  if (!is_dirty) {
+    dirty = rect;
+    is_dirty = true;
+  } else {
+    SDL_UnionRect(&dirty, &rect, &dirty);
+  }
+}
+
+static void reset_skyline(void) {
+  skyline[0] = (segment) { 0, reserved_height, reserved_width };
+  skyline[1] = (segment) { reserved_width, 0, GLYPH_ATLAS_SIZE - reserved_width };
+  segment_count = 2;
+}
+
+/* bottom left placement, lowest top edge first and leftmost on ties */
+static bool pack(int w, int h, SDL_Rect *out) {
+  int best = -1, best_x = 0, best_y = GLYPH_ATLAS_SIZE;
+
+  for (int i = 0; i < segment_count; i++) {
+    int x = skyline[i].x;
+    int y = 0;
+
+    if (x + w > GLYPH_ATLAS_SIZE) break;
+
+    for (int j = i, left = w; left > 0; j++) {
+      y = skyline[j].y > y ? skyline[j].y : y;
+      left -= skyline[j].w;
+    }
+
+    if (y + h <= GLYPH_ATLAS_SIZE && y < best_y) {
+      best = i;
+      best_x = x;
+      best_y = y;
+    }
+  }
+
+  if (best == -1 || segment_count == MAX_SEGMENTS) return false;
+
+  /* the new segment covers the placed rect, shorten what it overlaps */
+  memmove(&skyline[best + 1], &skyline[best], (segment_count - best) * sizeof(segment));
+  skyline[best] = (segment) { best_x, best_y + h, w };
+  segment_count++;
+
+  for (int i = best + 1; i < segment_count; ) {
+    int overlap = skyline[best].x + skyline[best].w - skyline[i].x;
+
+    if (overlap <= 0) break;
+
+    if (overlap >= skyline[i].w) {
+      memmove(&skyline[i], &skyline[i + 1], (segment_count - i - 1) * sizeof(segment));
+      segment_count--;
+    } else {
+      skyline[i].x += overlap;
+      skyline[i].w -= overlap;
+      break;
+    }
+  }
+
+  for (int i = 0; i + 1 < segment_count; ) {
+    if (skyline[i].y == skyline[i + 1].y) {
+      skyline[i].w += skyline[i + 1].w;
+      memmove(&skyline[i + 1], &skyline[i + 2], (segment_count - i - 2) * sizeof(segment));
+      segment_count--;
+    } else {
+      i++;
+    }
+  }
+
+  *out = (SDL_Rect) { best_x, best_y, w, h };
+  return true;
+}
+
+static SDL_Surface *render(int codepoint) {
+  SDL_Color white = { 255, 255, 255, 255 };
+
+  for (int i = 0; i < font_count; i++) {
+    if (!TTF_GlyphIsProvided32(fonts[i], codepoint)) continue;
+
+    SDL_Surface *surface = TTF_RenderGlyph32_Blended(fonts[i], codepoint, white);
+    if (surface == NULL) return NULL;
+
+    SDL_Surface *rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surface);
+
+    return rgba;
+  }
+
+  return NULL;
+}
+
+/* rasterises `g->codepoint` and packs it */
+static int place(glyph *g) {
+  SDL_Surface *surface = render(g->codepoint);
+
+  if (surface == NULL) return MISSING;
+
+  int w = surface->w;
+  int h = surface->h < glyph_height ? surface->h : glyph_height;
+
+  bool placed = pack(w, h, &g->rect);
+
+  if (placed) {
+    for (int y = 0; y < h; y++) {
+      memcpy(atlas + ((g->rect.y + y) * GLYPH_ATLAS_SIZE + g->rect.x) * 4,
+             (unsigned char*)surface->pixels + y * surface->pitch, w * 4);
+    }
+
+    g->uv[0] = g->rect.x / (float) GLYPH_ATLAS_SIZE;
+    g->uv[1] = g->rect.y / (float) GLYPH_ATLAS_SIZE;
+    g->uv[2] = (g->rect.x + g->rect.w) / (float) GLYPH_ATLAS_SIZE;
+    g->uv[3] = (g->rect.y + g->rect.h) / (float) GLYPH_ATLAS_SIZE;
+
+    mark_dirty(g->rect);
+    rasterized++;
+  }
+
+  SDL_FreeSurface(surface);
+
+  return placed ? PLACED : FULL;
+}
+
+static void link_glyph(int index) {
+  int bucket = glyph_table[index].codepoint % BUCKETS;
+
+  glyph_table[index].next = buckets[bucket];
+  buckets[bucket] = index;
+}
+
+/* keeps the glyphs of the current and previous frame, drops the rest */
+static void evict(unsigned frame) {
+  static glyph survivors[GLYPH_CAPACITY];
+  int survivor_count = 0;
+
+  for (int i = 0; i < glyph_count; i++) {
+    if (glyph_table[i].last_used + 1 >= frame) {
+      survivors[survivor_count++] = glyph_table[i];
+    }
+  }
+
+  for (int i = 0; i < BUCKETS; i++) {
+    buckets[i] = -1;
+  }
+
+  glyph_count = 0;
+  reset_skyline();
+
+  for (int y = 0; y < GLYPH_ATLAS_SIZE; y++) {
+    int x = y < reserved_height ? reserved_width : 0;
+    memset(atlas + (y * GLYPH_ATLAS_SIZE + x) * 4, 0, (GLYPH_ATLAS_SIZE - x) * 4);
+  }
+
+  mark_dirty((SDL_Rect) { 0, 0, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE });
+
+  for (int i = 0; i < survivor_count; i++) {
+    glyph_table[glyph_count] = survivors[i];
+
+    if (place(&glyph_table[glyph_count]) == PLACED) {
+      link_glyph(glyph_count++);
+    }
+  }
+
+  generation++;
+}
+
+/*
+** `pixels` is the rgba atlas, GLYPH_ATLAS_SIZE square. the reserved
+** corner is left alone and glyphs are at most `max_height` tall.
+** SAP_FONT names a font to try before the usual system ones.
+*/
+void glyphs_init(unsigned char *pixels, int reserved_w, int reserved_h, int max_height) {
+  atlas = pixels;
+  reserved_width = reserved_w;
+  reserved_height = reserved_h;
+  glyph_height = max_height;
+
+  for (int i = 0; i < BUCKETS; i++) {
+    buckets[i] = -1;
+  }
+
+  reset_skyline();
+
+  if (TTF_Init() != 0) return;
+
+  const char *forced = getenv("SAP_FONT");
+
+  if (forced != NULL) {
+    open_font(forced);
+  }
+
+  for (int i = 0; i < (int)(sizeof(font_paths) / sizeof(font_paths[0])); i++) {
+    open_font(font_paths[i]);
+  }
+}
+
+/*
+** NULL when no font has the glyph. a full atlas is evicted first, so
+** `before_evict` has to submit anything that still samples the old layout.
+*/
+const glyph *glyphs_get(int codepoint, unsigned frame, void (*before_evict)(void)) {
+  for (int i = buckets[codepoint % BUCKETS]; i != -1; i = glyph_table[i].next) {
+    if (glyph_table[i].codepoint == codepoint) {
+      glyph_table[i].last_used = frame;
+      return &glyph_table[i];
+    }
+  }
+
+  if (font_count == 0) return NULL;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (glyph_count < GLYPH_CAPACITY) {
+      glyph *g = &glyph_table[glyph_count];
+
+      g->codepoint = codepoint;
+      g->last_used = frame;
+
+      int result = place(g);
+
+      if (result == PLACED) {
+        link_glyph(glyph_count++);
+        return g;
+      }
+
+      /* no font has it, evicting would not help */
+      if (result == MISSING) return NULL;
+    }
+
+    before_evict();
+    evict(frame);
+  }
+
+  return NULL;
+}
+
+bool glyphs_take_dirty(SDL_Rect *rect) {
+  if (!is_dirty) return false;
+
+  *rect = dirty;
+  is_dirty = false;
+
+  return true;
+}
+
+/* bumped whenever glyphs move */
+unsigned glyphs_generation(void) {
+  return generation;
+}
+
+unsigned glyphs_rasterized(void) {
+  return rasterized;
+}
+
+/* next codepoint of utf-8 `text`, advancing it; malformed bytes give U+FFFD */
+int glyphs_decode(const char **text) {
+  const unsigned char *p = (const unsigned char*)*text;
+  int codepoint, extra;
+
+  if (p[0] < 0x80) {
+    *text += 1;
+    return p[0];
+  } else if ((p[0] & 0xe0) == 0xc0) {
+    codepoint = p[0] & 0x1f;
+    extra = 1;
+  } else if ((p[0] & 0xf0) == 0xe0) {
+    codepoint = p[0] & 0x0f;
+    extra = 2;
+  } else if ((p[0] & 0xf8) == 0xf0) {
+    codepoint = p[0] & 0x07;
+    extra = 3;
+  } else {
+    *text += 1;
+    return 0xfffd;
+  }
+
+  for (int i = 1; i <= extra; i++) {
+    if ((p[i] & 0xc0) != 0x80) {
+      *text += i;
+      return 0xfffd;
+    }
+    codepoint = (codepoint << 6) | (p[i] & 0x3f);
+  }
+
+  *text += extra + 1;
+  return codepoint;
+}
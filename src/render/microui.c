@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include "microui.h"
 
@@ -41,6 +42,24 @@
     (stk).idx++; /* incremented after incase `val` uses this value */       \
   } while (0)
 
+/* grows `stk` to hold `n` items, its capacity is kept from frame to frame */
+#define grow(stk, n) do {                                               \
+    if ((n) > (stk).cap) {                                              \
+      int cap_ = (stk).cap ? (stk).cap : 16;                            \
+      while (cap_ < (n)) { cap_ *= 2; }                                 \
+      (stk).items = realloc((stk).items, cap_ * sizeof(*(stk).items));  \
+      expect((stk).items);                                              \
+      (stk).cap = cap_;                                                 \
+    }                                                                   \
+    if ((n) > (stk).peak) { (stk).peak = (n); }                         \
+  } while (0)
+
+#define push_grow(stk, val) do {  \
+    grow(stk, (stk).idx + 1);     \
+    (stk).items[(stk).idx] = (val); \
+    (stk).idx++;                  \
+  } while (0)
+
 #define pop(stk) do {      \
     expect((stk).idx > 0); \
     (stk).idx--;           \
@@ -127,11 +146,65 @@ static void draw_frame(mu_Context *ctx, mu_Rect rect, int colorid) {
 }
 
 
+static void pool_alloc(mu_Pool *pool, int len) {
+  int i, cap = 1;
+  /* at most half full, so every probe reaches an empty slot */
+  while (cap < len * 2) { cap <<= 1; }
+  pool->items = calloc(len, sizeof(mu_PoolItem));
+  pool->slots = calloc(cap, sizeof(int));
+  pool->free = malloc(len * sizeof(int));
+  expect(pool->items && pool->slots && pool->free);
+  pool->len = len;
+  pool->mask = cap - 1;
+  /* handed out from index 0 upward */
+  for (i = 0; i < len; i++) { pool->free[i] = len - 1 - i; }
+  pool->free_count = len;
+}
+
+
+static void pool_free(mu_Pool *pool) {
+  free(pool->items);
+  free(pool->slots);
+  free(pool->free);
+}
+
+
 void mu_init(mu_Context *ctx) {
+  mu_init_ex(ctx, MU_CONTAINERPOOL_SIZE, MU_TREENODEPOOL_SIZE);
+}
+
+
+void mu_init_ex(mu_Context *ctx, int containers, int treenodes) {
+  expect(containers > 0 && treenodes > 0);
   memset(ctx, 0, sizeof(*ctx));
   ctx->draw_frame = draw_frame;
   ctx->_style = default_style;
   ctx->style = &ctx->_style;
+  grow(ctx->command_list, MU_COMMANDLIST_SIZE);
+  grow(ctx->root_list, MU_ROOTLIST_SIZE);
+  grow(ctx->container_stack, MU_CONTAINERSTACK_SIZE);
+  grow(ctx->id_stack, MU_IDSTACK_SIZE);
+  ctx->command_list.peak = ctx->root_list.peak = 0;
+  ctx->container_stack.peak = ctx->id_stack.peak = 0;
+  pool_alloc(&ctx->container_pool, containers);
+  pool_alloc(&ctx->treenode_pool, treenodes);
+  ctx->containers = calloc(containers, sizeof(mu_Container));
+  expect(ctx->containers);
+}
+
+
+void mu_free(mu_Context *ctx) {
+  int i;
+  pool_free(&ctx->container_pool);
+  pool_free(&ctx->treenode_pool);
+  for (i = 0; i < ctx->container_pool.len; i++) {
+    free(ctx->containers[i].retained);
+  }
+  free(ctx->containers);
+  free(ctx->command_list.items);
+  free(ctx->root_list.items);
+  free(ctx->container_stack.items);
+  free(ctx->id_stack.items);
 }
 
 
@@ -237,7 +310,7 @@ mu_Id mu_get_id(mu_Context *ctx, const void *data, int size) {
 
 
 void mu_push_id(mu_Context *ctx, const void *data, int size) {
-  push(ctx->id_stack, mu_get_id(ctx, data, size));
+  push_grow(ctx->id_stack, mu_get_id(ctx, data, size));
 }
 
 
@@ -310,19 +383,21 @@ mu_Container* mu_get_current_container(mu_Context *ctx) {
 static mu_Container* get_container(mu_Context *ctx, mu_Id id, int opt) {
   mu_Container *cnt;
   /* try to get existing container from pool */
-  int idx = mu_pool_get(ctx, ctx->container_pool, MU_CONTAINERPOOL_SIZE, id);
+  int idx = mu_pool_get(ctx, &ctx->container_pool, id);
   if (idx >= 0) {
     if (ctx->containers[idx].open || ~opt & MU_OPT_CLOSED) {
-      mu_pool_update(ctx, ctx->container_pool, idx);
+      mu_pool_update(ctx, &ctx->container_pool, idx);
     }
     return &ctx->containers[idx];
   }
   if (opt & MU_OPT_CLOSED) { return NULL; }
   /* container not found in pool: init new container */
-  idx = mu_pool_init(ctx, ctx->container_pool, MU_CONTAINERPOOL_SIZE, id);
+  idx = mu_pool_init(ctx, &ctx->container_pool, id);
   cnt = &ctx->containers[idx];
+  free(cnt->retained);
   memset(cnt, 0, sizeof(*cnt));
   cnt->open = 1;
+  cnt->retain_start = MU_RETAIN_NONE;
   mu_bring_to_front(ctx, cnt);
   return cnt;
 }
@@ -343,33 +418,78 @@ void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt) {
 ** pool
 **============================================================================*/
 
-int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
+static int pool_find_slot(mu_Pool *pool, mu_Id id) {
+  int i = id & pool->mask;
+  while (pool->slots[i]) {
+    if (pool->items[pool->slots[i] - 1].id == id) { return i; }
+    i = (i + 1) & pool->mask;
+  }
+  return -1;
+}
+
+
+static void pool_unlink(mu_Pool *pool, int idx) {
+  int i = pool_find_slot(pool, pool->items[idx].id), j = i;
+  expect(i >= 0);
+  pool->slots[i] = 0;
+  /* shift later entries of the probe run back into the hole, unless their
+  ** home slot lies between the hole and where they are */
+  for (;;) {
+    int home;
+    j = (j + 1) & pool->mask;
+    if (!pool->slots[j]) { break; }
+    home = pool->items[pool->slots[j] - 1].id & pool->mask;
+    if (((j - home) & pool->mask) >= ((j - i) & pool->mask)) {
+      pool->slots[i] = pool->slots[j];
+      pool->slots[j] = 0;
+      i = j;
+    }
+  }
+}
+
+
+int mu_pool_init(mu_Context *ctx, mu_Pool *pool, mu_Id id) {
   int i, n = -1, f = ctx->frame;
-  for (i = 0; i < len; i++) {
-    if (items[i].last_update < f) {
-      f = items[i].last_update;
-      n = i;
+  if (pool->free_count > 0) {
+    n = pool->free[--pool->free_count];
+  } else {
+    /* full: evict the least recently used item */
+    for (i = 0; i < pool->len; i++) {
+      if (pool->items[i].last_update < f) {
+        f = pool->items[i].last_update;
+        n = i;
+      }
     }
+    expect(n > -1);
+    pool_unlink(pool, n);
   }
-  expect(n > -1);
-  items[n].id = id;
-  mu_pool_update(ctx, items, n);
+  pool->items[n].id = id;
+  i = id & pool->mask;
+  while (pool->slots[i]) { i = (i + 1) & pool->mask; }
+  pool->slots[i] = n + 1;
+  mu_pool_update(ctx, pool, n);
   return n;
 }
 
 
-int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
+int mu_pool_get(mu_Context *ctx, mu_Pool *pool, mu_Id id) {
   int i;
   unused(ctx);
-  for (i = 0; i < len; i++) {
-    if (items[i].id == id) { return i; }
-  }
-  return -1;
+  i = pool_find_slot(pool, id);
+  return i < 0 ? -1 : pool->slots[i] - 1;
 }
 
 
-void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx) {
-  items[idx].last_update = ctx->frame;
+void mu_pool_update(mu_Context *ctx, mu_Pool *pool, int idx) {
+  pool->items[idx].last_update = ctx->frame;
+}
+
+
+void mu_pool_remove(mu_Context *ctx, mu_Pool *pool, int idx) {
+  unused(ctx);
+  pool_unlink(pool, idx);
+  memset(&pool->items[idx], 0, sizeof(mu_PoolItem));
+  pool->free[pool->free_count++] = idx;
 }
 
 
@@ -424,9 +544,47 @@ void mu_input_text(mu_Context *ctx, const char *text) {
 ** commandlist
 **============================================================================*/
 
+static void* shift(void *p, uintptr_t from, uintptr_t to) {
+  return p ? (void*) ((uintptr_t) p - from + to) : p;
+}
+
+
+/* moves the jumps and root container ends pointing into the list from
+** base `from` to base `to` */
+static void relocate(mu_Context *ctx, uintptr_t from, uintptr_t to) {
+  mu_Command *cmd;
+  int i;
+  for (i = 0; i < ctx->command_list.idx; i += cmd->base.size) {
+    cmd = (mu_Command*) (ctx->command_list.items + i);
+    if (cmd->type == MU_COMMAND_JUMP) {
+      cmd->jump.dst = shift(cmd->jump.dst, from, to);
+    }
+  }
+  for (i = 0; i < ctx->root_list.idx; i++) {
+    mu_Container *cnt = ctx->root_list.items[i];
+    cnt->head = shift(cnt->head, from, to);
+    cnt->tail = shift(cnt->tail, from, to);
+  }
+}
+
+
+static void grow_command_list(mu_Context *ctx, int size) {
+  int n = ctx->command_list.idx + size;
+  if (n <= ctx->command_list.cap) {
+    grow(ctx->command_list, n);
+    return;
+  }
+  /* the buffer may move: hold the pointers into it as offsets meanwhile */
+  relocate(ctx, (uintptr_t) ctx->command_list.items, 0);
+  grow(ctx->command_list, n);
+  relocate(ctx, 0, (uintptr_t) ctx->command_list.items);
+}
+
+
 mu_Command* mu_push_command(mu_Context *ctx, int type, int size) {
-  mu_Command *cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
-  expect(ctx->command_list.idx + size < MU_COMMANDLIST_SIZE);
+  mu_Command *cmd;
+  grow_command_list(ctx, size);
+  cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
   cmd->base.type = type;
   cmd->base.size = size;
   ctx->command_list.idx += size;
@@ -520,6 +678,39 @@ void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color) {
 }
 
 
+void mu_draw_quads(mu_Context *ctx, const mu_Rect *rects, int count,
+  mu_Color color)
+{
+  mu_Command *cmd;
+  mu_Rect bounds;
+  int i, clipped, x2, y2;
+  if (count <= 0) { return; }
+  /* clip against the bounding rect of all quads, like text */
+  bounds = rects[0];
+  x2 = bounds.x + bounds.w;
+  y2 = bounds.y + bounds.h;
+  for (i = 1; i < count; i++) {
+    bounds.x = mu_min(bounds.x, rects[i].x);
+    bounds.y = mu_min(bounds.y, rects[i].y);
+    x2 = mu_max(x2, rects[i].x + rects[i].w);
+    y2 = mu_max(y2, rects[i].y + rects[i].h);
+  }
+  bounds.w = x2 - bounds.x;
+  bounds.h = y2 - bounds.y;
+  clipped = mu_check_clip(ctx, bounds);
+  if (clipped == MU_CLIP_ALL ) { return; }
+  if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
+  /* add command */
+  cmd = mu_push_command(ctx, MU_COMMAND_QUADS,
+    sizeof(mu_QuadsCommand) + (count - 1) * sizeof(mu_Rect));
+  memcpy(cmd->quads.rects, rects, count * sizeof(mu_Rect));
+  cmd->quads.count = count;
+  cmd->quads.color = color;
+  /* reset clipping if it was set */
+  if (clipped) { mu_set_clip(ctx, unclipped_rect); }
+}
+
+
 /*============================================================================
 ** layout
 **============================================================================*/
@@ -927,7 +1118,7 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
   mu_Rect r;
   int active, expanded;
   mu_Id id = mu_get_id(ctx, label, strlen(label));
-  int idx = mu_pool_get(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
+  int idx = mu_pool_get(ctx, &ctx->treenode_pool, id);
   int width = -1;
   mu_layout_row(ctx, 1, &width, 0);
 
@@ -941,10 +1132,10 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
 
   /* update pool ref */
   if (idx >= 0) {
-    if (active) { mu_pool_update(ctx, ctx->treenode_pool, idx); }
-           else { memset(&ctx->treenode_pool[idx], 0, sizeof(mu_PoolItem)); }
+    if (active) { mu_pool_update(ctx, &ctx->treenode_pool, idx); }
+           else { mu_pool_remove(ctx, &ctx->treenode_pool, idx); }
   } else if (active) {
-    mu_pool_init(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
+    mu_pool_init(ctx, &ctx->treenode_pool, id);
   }
 
   /* draw */
@@ -973,7 +1164,7 @@ int mu_begin_treenode_ex(mu_Context *ctx, const char *label, int opt) {
   int res = header(ctx, label, 1, opt);
   if (res & MU_RES_ACTIVE) {
     get_layout(ctx)->indent += ctx->style->indent;
-    push(ctx->id_stack, ctx->last_id);
+    push_grow(ctx->id_stack, ctx->last_id);
   }
   return res;
 }
@@ -1049,10 +1240,31 @@ static void push_container_body(
 }
 
 
+static int keep_retained(mu_Context *ctx, mu_Container *cnt) {
+  int i, size = ctx->command_list.idx - cnt->retain_start;
+  char *start = ctx->command_list.items + cnt->retain_start;
+  /* a root container begun inside leaves jumps that cannot be moved */
+  for (i = 0; i < size; i += ((mu_Command*) (start + i))->base.size) {
+    if (((mu_Command*) (start + i))->type == MU_COMMAND_JUMP) {
+      cnt->retained_key = 0;
+      return 0;
+    }
+  }
+  if (size > cnt->retained_cap) {
+    cnt->retained = realloc(cnt->retained, size);
+    expect(cnt->retained);
+    cnt->retained_cap = size;
+  }
+  memcpy(cnt->retained, start, size);
+  cnt->retained_size = size;
+  return 1;
+}
+
+
 static void begin_root_container(mu_Context *ctx, mu_Container *cnt) {
-  push(ctx->container_stack, cnt);
+  push_grow(ctx->container_stack, cnt);
   /* push container to roots list and push head command */
-  push(ctx->root_list, cnt);
+  push_grow(ctx->root_list, cnt);
   cnt->head = push_jump(ctx, NULL);
   /* set as hover root if the mouse is overlapping this container and it has a
   ** higher zindex than the current hover root */
@@ -1072,11 +1284,19 @@ static void end_root_container(mu_Context *ctx) {
   /* push tail 'goto' jump command and set head 'skip' command. the final steps
   ** on initing these are done in mu_end() */
   mu_Container *cnt = mu_get_current_container(ctx);
+  int kept = cnt->retain_start >= 0 && keep_retained(ctx, cnt);
   cnt->tail = push_jump(ctx, NULL);
   cnt->head->jump.dst = ctx->command_list.items + ctx->command_list.idx;
   /* pop base clip rect and container */
   mu_pop_clip_rect(ctx);
   pop_container(ctx);
+  /* nothing was laid out, the size is the one the commands were built with */
+  if (cnt->retain_start == MU_RETAIN_REPLAYED) {
+    cnt->content_size = cnt->retained_content;
+  } else if (kept) {
+    cnt->retained_content = cnt->content_size;
+  }
+  cnt->retain_start = MU_RETAIN_NONE;
 }
 
 
@@ -1085,7 +1305,7 @@ int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt
   mu_Id id = mu_get_id(ctx, title, strlen(title));
   mu_Container *cnt = get_container(ctx, id, opt);
   if (!cnt || !cnt->open) { return 0; }
-  push(ctx->id_stack, id);
+  push_grow(ctx->id_stack, id);
 
   if (cnt->rect.w == 0) { cnt->rect = rect; }
   begin_root_container(ctx, cnt);
@@ -1165,6 +1385,50 @@ void mu_end_window(mu_Context *ctx) {
 }
 
 
+/*
+** call right after a window begins. when nothing its contents are built from
+** changed since the frame they were kept, the window's commands from that
+** frame are copied in and 1 is returned: the caller skips building them and
+** goes on to mu_end_window(). `version` must change whenever the caller's
+** data does. the window's size, body, scroll and the style are checked here,
+** and it is always rebuilt while the mouse is over it, was over it last
+** frame, or there is focus or new input, since building handles those
+*/
+int mu_retain(mu_Context *ctx, unsigned version) {
+  mu_Container *cnt = mu_get_current_container(ctx);
+  mu_Id key = HASH_INITIAL;
+  int over = rect_overlaps_vec2(cnt->rect, ctx->mouse_pos);
+  int quiet = !over && !cnt->retained_over && !ctx->focus &&
+    !ctx->mouse_pressed && !ctx->key_pressed && !ctx->input_text[0] &&
+    !ctx->scroll_delta.x && !ctx->scroll_delta.y;
+  cnt->retained_over = over;
+
+  hash(&key, &cnt->rect, sizeof(cnt->rect));
+  hash(&key, &cnt->body, sizeof(cnt->body));
+  hash(&key, &cnt->scroll, sizeof(cnt->scroll));
+  hash(&key, ctx->style, sizeof(*ctx->style));
+  hash(&key, &version, sizeof(version));
+
+  if (!quiet) {
+    cnt->retained_key = 0;
+    return 0;
+  }
+
+  if (cnt->retained && key == cnt->retained_key) {
+    grow_command_list(ctx, cnt->retained_size);
+    memcpy(ctx->command_list.items + ctx->command_list.idx, cnt->retained, cnt->retained_size);
+    ctx->command_list.idx += cnt->retained_size;
+    cnt->retain_start = MU_RETAIN_REPLAYED;
+    return 1;
+  }
+
+  /* built now and kept at mu_end_window() */
+  cnt->retained_key = key;
+  cnt->retain_start = ctx->command_list.idx;
+  return 0;
+}
+
+
 void mu_open_popup(mu_Context *ctx, const char *name) {
   mu_Container *cnt = mu_get_container(ctx, name);
   /* set as hover root so popup isn't closed in begin_window_ex()  */
@@ -1196,7 +1460,7 @@ void mu_begin_panel_ex(mu_Context *ctx, const char *name, int opt) {
   if (~opt & MU_OPT_NOFRAME) {
     ctx->draw_frame(ctx, cnt->rect, MU_COLOR_PANELBG);
   }
-  push(ctx->container_stack, cnt);
+  push_grow(ctx->container_stack, cnt);
   push_container_body(ctx, cnt, cnt->rect, opt);
   mu_push_clip_rect(ctx, cnt->body);
 }
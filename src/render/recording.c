@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <recording.h>
+
+/* flattened commands of the frame being written, as big as the command
+** list has been */
+static char *flat;
+static int flat_capacity = 0;
+
+/* call before process_frame, mu_end clears what was pressed */
+void recording_capture_input(mu_Context *ctx, recording_input *input) {
+  memset(input, 0, sizeof(*input));
+
+  input->mouse_pos = ctx->mouse_pos;
+  input->scroll_delta = ctx->scroll_delta;
+  input->mouse_down = ctx->mouse_down;
+  input->mouse_pressed = ctx->mouse_pressed;
+  input->key_down = ctx->key_down;
+  input->key_pressed = ctx->key_pressed;
+  memcpy(input->input_text, ctx->input_text, sizeof(input->input_text));
+}
+
+bool recording_write_header(FILE *f) {
+  return fwrite(RECORDING_MAGIC, 1, 8, f) == 8;
+}
+
+bool recording_check_header(FILE *f) {
+  char magic[8];
+
+  return fread(magic, 1, 8, f) == 8 && memcmp(magic, RECORDING_MAGIC, 8) == 0;
+}
+
+bool recording_write_frame(FILE *f, const recording_input *input, const mu_Rect *damage, int damage_count, mu_Context *ctx) {
+  mu_Command *cmd = NULL;
+  int size = 0;
+
+  if (ctx->command_list.idx > flat_capacity) {
+    flat_capacity = ctx->command_list.cap;
+    flat = realloc(flat, flat_capacity);
+
+    if (flat == NULL) {
+      flat_capacity = 0;
+      return false;
+    }
+  }
+
+  while (mu_next_command(ctx, &cmd)) {
+    memcpy(flat + size, cmd, cmd->base.size);
+    size += cmd->base.size;
+  }
+
+  return fwrite(input, sizeof(*input), 1, f) == 1 &&
+         fwrite(&damage_count, sizeof(damage_count), 1, f) == 1 &&
+         fwrite(damage, sizeof(mu_Rect), damage_count, f) == (size_t)damage_count &&
+         fwrite(&size, sizeof(size), 1, f) == 1 &&
+         fwrite(flat, 1, size, f) == (size_t)size;
+}
+
+/* `damage` holds DAMAGE_MAX_RECTS, `commands` is grown to fit the frame and
+** `capacity` follows it. false at the end or on a short read */
+bool recording_read_frame(FILE *f, recording_input *input, mu_Rect *damage, int *damage_count, char **commands, int *capacity, int *size) {
+  if (fread(input, sizeof(*input), 1, f) != 1 || fread(damage_count, sizeof(*damage_count), 1, f) != 1) {
+    return false;
+  }
+
+  if (*damage_count < 0 || *damage_count > DAMAGE_MAX_RECTS ||
+      fread(damage, sizeof(mu_Rect), *damage_count, f) != (size_t)*damage_count) {
+    return false;
+  }
+
+  if (fread(size, sizeof(*size), 1, f) != 1 || *size < 0) {
+    return false;
+  }
+
+  if (*size > *capacity) {
+    char *grown = realloc(*commands, *size);
+
+    if (grown == NULL) {
+      return false;
+    }
+
+    *commands = grown;
+    *capacity = *size;
+  }
+
+  return fread(*commands, 1, *size, f) == (size_t)*size;
+}
@@ -1,233 +1,840 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include <SDL2/SDL.h>
 
 #include <microui.h>
+#include <renderer.h>
+#include <glyphs.h>
 
 #include "atlas.h"
+#include "atlas_rgba.h"
 
-#define BUFFER_SIZE 16384
+/* the batch grows up to BATCH_MAX quads, larger frames are submitted in
+** several batches before the single present */
+#define BATCH_MIN 1024
+#define BATCH_MAX 65536
+#define SPECTROGRAM_COLUMNS 512
 
-static float         tex_buf[BUFFER_SIZE *  8];
-static float         vert_buf[BUFFER_SIZE *  8];
-static unsigned char color_buf[BUFFER_SIZE * 16];
-static int           index_buf[BUFFER_SIZE *  6];
+/* height of the ascii glyphs, other glyphs are centred on it */
+#define GLYPH_HEIGHT 16
+
+#define TEXT_CACHE_SIZE 512
+#define TEXT_BUCKETS 1024
+
+static SDL_Vertex *vert_buf;
+static int buf_cap = 0;
+
+/* every quad uses the same six indices, so they are built once for a full batch */
+static int *index_buf;
+
+/* atlas rects as texture coordinates, x0 y0 x1 y1 */
+static float atlas_uv[sizeof(atlas) / sizeof(atlas[0])][4];
 
 static SDL_Window *window;
 
+/* set when rendering headless, the software renderer draws into it */
+static SDL_Surface *offscreen;
+
 static SDL_Texture *texture;
+static unsigned char *atlas_pixels;
 static SDL_Renderer *renderer;
 
 static int height, width;
 
 static int buf_idx;
 
+static const mu_Rect unclipped = { 0, 0, 0x1000000, 0x1000000 };
+
+/* applied on the cpu as quads are queued, so a batch never needs a
+** clip state change. it never reaches outside `damage_rect` */
+static mu_Rect clip_rect = { 0, 0, 0x1000000, 0x1000000 };
+
+/* frames are drawn into `target` and copied to the screen, so whatever
+** lies outside the damage rect keeps what earlier frames drew there */
+static SDL_Texture *target;
+static int target_w, target_h;
+static mu_Rect damage_rect = { 0, 0, 0x1000000, 0x1000000 };
+
+/* the spectrogram is a ring of columns, `spectrogram_head` is the oldest */
+static SDL_Texture *spectrogram;
+static int spectrogram_rows = 0;
+static int spectrogram_head = 0;
+static unsigned char spectrogram_lut[256][4];
+
+static sdlr_stats stats, last_stats;
+static unsigned frame_count = 0;
+static unsigned rasterized_before = 0;
+
+/* a drawn string in one colour, its glyph quads laid out from (0, 0). the
+** text and vertex storage is kept when the entry is reused */
+typedef struct {
+  char *text;
+  /* bytes the text can hold, the vertices hold one glyph fewer */
+  int text_cap;
+  /* of the text alone, so the width can be found without a colour */
+  unsigned hash;
+  mu_Color color;
+  int glyphs;
+  int width;
+  SDL_Vertex *vertices;
+  unsigned generation;
+  /* the bucket chain, and the neighbours in drawing order */
+  int next;
+  int newer, older;
+} text_run;
+
+static text_run text_runs[TEXT_CACHE_SIZE];
+static int text_run_count = 0;
+static int text_buckets[TEXT_BUCKETS];
+/* the most and least recently drawn runs */
+static int newest_run = -1, oldest_run = -1;
+
+static void init_spectrogram_lut(void) {
+  /* black -> violet -> orange -> pale yellow */
+  static const float stops[4][3] = {
+    {   0,   0,   0 },
+    { 110,  30, 160 },
+    { 240, 120,  40 },
+    { 255, 250, 190 }
+  };
+
+  for (int i = 0; i < 256; i++) {
+    float t = i / 255.0f * 3;
+    int stop = t < 2 ? (int)t : 2;
+    float f = t - stop;
+
+    for (int c = 0; c < 3; c++) {
+      spectrogram_lut[i][c] = stops[stop][c] + (stops[stop + 1][c] - stops[stop][c]) * f;
+    }
+
+    spectrogram_lut[i][3] = 255;
+  }
+}
+
 void sdlr_init(void) {
-   window = SDL_CreateWindow(
-    "sap", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-    800, 700, SDL_WINDOW_SHOWN);
+  /* SAP_HEADLESS needs no display, frames go to an rgba surface */
+  if (getenv("SAP_HEADLESS") != NULL) {
+    offscreen = SDL_CreateRGBSurfaceWithFormat(0, 800, 700, 32, SDL_PIXELFORMAT_RGBA32);
+    renderer = SDL_CreateSoftwareRenderer(offscreen);
+  } else {
+    window = SDL_CreateWindow(
+      "sap", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+      800, 700, SDL_WINDOW_SHOWN);
+
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+  }
 
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-  texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, ATLAS_HEIGHT);
+  texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
 
-  unsigned char rgba_texture[ATLAS_WIDTH * ATLAS_HEIGHT * 4];
-  unsigned char byte_texture[ATLAS_HEIGHT][ATLAS_WIDTH];
+  /* the ascii atlas is built by atlasgen, glyphs.c fills in the rest */
+  atlas_pixels = calloc(GLYPH_ATLAS_SIZE * GLYPH_ATLAS_SIZE, 4);
 
-	for(int i = 0; i < ATLAS_HEIGHT; i++) {
-    for(int j = 0; j < ATLAS_WIDTH; j++) {
-      byte_texture[i][j] = 0;
-    }
+  for (int i = 0; i < ATLAS_HEIGHT; i++) {
+    memcpy(atlas_pixels + i * GLYPH_ATLAS_SIZE * 4, atlas_rgba + i * ATLAS_WIDTH * 4, ATLAS_WIDTH * 4);
   }
 
-  unsigned char r, g, b, a;
-	int rgba_index = 0;
+  SDL_UpdateTexture(texture, NULL, atlas_pixels, 4 * GLYPH_ATLAS_SIZE);
+  /* SAP_NOVSYNC lets benchmarks run past the refresh rate */
+  SDL_RenderSetVSync(renderer, getenv("SAP_NOVSYNC") == NULL);
 
-	for(int i = 0; i < ATLAS_HEIGHT; i++) {
-    for(int j = 0; j < ATLAS_WIDTH; j++) {
-    
-      char current_char = atlas_texture[i][j];
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
 
-      if (current_char == '*') {
-        byte_texture[i][j] = 1;
-                   
-        for (int dy = -1; dy <= 1; dy++) {
-          for (int dx = -1; dx <= 1; dx++) {
-            if (dx == 0 && dy == 0) continue;
+  for (int i = 0; i < (int)(sizeof(atlas) / sizeof(atlas[0])); i++) {
+    atlas_uv[i][0] = atlas[i].x / (float) GLYPH_ATLAS_SIZE;
+    atlas_uv[i][1] = atlas[i].y / (float) GLYPH_ATLAS_SIZE;
+    atlas_uv[i][2] = (atlas[i].x + atlas[i].w) / (float) GLYPH_ATLAS_SIZE;
+    atlas_uv[i][3] = (atlas[i].y + atlas[i].h) / (float) GLYPH_ATLAS_SIZE;
+  }
 
-            int ny = i + dy;
-            int nx = j + dx;
+  glyphs_init(atlas_pixels, ATLAS_WIDTH, ATLAS_HEIGHT, GLYPH_HEIGHT);
 
-            if (ny >= 0 && nx >= 0 && ny < ATLAS_HEIGHT && nx < ATLAS_WIDTH) {
-              if (byte_texture[ny][nx] == 0) {
-                byte_texture[ny][nx] = 2;
-              }
-            }
-          }
-        }
-      }
-    }
+  for (int i = 0; i < TEXT_BUCKETS; i++) {
+    text_buckets[i] = -1;
   }
 
-  for(int i = 0; i < ATLAS_HEIGHT; i++) {
-    for(int j = 0; j < ATLAS_WIDTH; j++) {
-      unsigned char atlas_cur = byte_texture[i][j];
-
-			if (atlas_cur == 1) {
-				r = 255;
-				g = 255;
-				b = 255;
-				a = 255;
-			} else if (atlas_cur == 2) {
-				r = 0;
-				g = 0;
-				b = 0;
-				a = 255;
-			} else {
-        r = 0;
-				g = 0;
-				b = 0;
-				a = 0;
-			}
-
-      rgba_texture[rgba_index++] = r;
-      rgba_texture[rgba_index++] = g;
-      rgba_texture[rgba_index++] = b;
-      rgba_texture[rgba_index++] = a;
-    }
+  index_buf = malloc(BATCH_MAX * 6 * sizeof(int));
+
+  for (int i = 0; i < BATCH_MAX; i++) {
+    index_buf[i * 6 + 0] = i * 4 + 0;
+    index_buf[i * 6 + 1] = i * 4 + 1;
+    index_buf[i * 6 + 2] = i * 4 + 2;
+    index_buf[i * 6 + 3] = i * 4 + 2;
+    index_buf[i * 6 + 4] = i * 4 + 3;
+    index_buf[i * 6 + 5] = i * 4 + 1;
   }
 
-  SDL_UpdateTexture(texture, NULL, rgba_texture, 4 * ATLAS_WIDTH);
-  SDL_RenderSetVSync(renderer, 1);
+  init_spectrogram_lut();
+}
 
-  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
- 
+static void update_size(void) {
+  if (offscreen != NULL) {
+    width = offscreen->w;
+    height = offscreen->h;
+  } else {
+    SDL_GetWindowSize(window, &width, &height);
+  }
 }
 
+/* submits the queued quads, the frame is only shown by sdlr_present */
 void sdlr_flush(void) {
   if (buf_idx == 0) { return; }
 
-  SDL_GetWindowSize(window, &width, &height);
+  /* glyphs rasterised since the last batch */
+  SDL_Rect dirty;
+  if (glyphs_take_dirty(&dirty)) {
+    SDL_UpdateTexture(texture, &dirty, atlas_pixels + (dirty.y * GLYPH_ATLAS_SIZE + dirty.x) * 4, GLYPH_ATLAS_SIZE * 4);
+  }
+
+  update_size();
+
   SDL_Rect viewport = {0, 0, width, height};
   SDL_RenderSetViewport(renderer, &viewport);
 
-  int xy_stride = 2 * sizeof(float);
-  float *xy = vert_buf;
+  SDL_RenderGeometry(renderer, texture, vert_buf, buf_idx * 4, index_buf, buf_idx * 6);
 
-  int uv_stride = 2 * sizeof(float);
-  float *uv = tex_buf;
+  stats.quads += buf_idx;
+  stats.batches++;
 
-  int col_stride = 4 * sizeof(uint8_t);
-  SDL_Color *color = (SDL_Color*)color_buf;
+  buf_idx = 0;
+}
 
-  SDL_RenderGeometryRaw(renderer, texture,
-          xy, xy_stride, color,
-          col_stride,
-          uv, uv_stride,
-          buf_idx * 4,
-          index_buf, buf_idx * 6, sizeof (int));
+static void grow_batch(void) {
+  buf_cap = buf_cap ? buf_cap * 2 : BATCH_MIN;
 
-  SDL_RenderPresent(renderer);
+  vert_buf = realloc(vert_buf, buf_cap * 4 * sizeof(SDL_Vertex));
+  stats.allocations++;
+}
 
-  buf_idx = 0;
+static void reserve_quad(void) {
+  if (buf_idx == buf_cap) {
+    if (buf_cap < BATCH_MAX) {
+      grow_batch();
+    } else {
+      sdlr_flush();
+    }
+  }
 }
 
-static void push_quad(mu_Rect dst, mu_Rect src, mu_Color color) {
-  if (buf_idx == BUFFER_SIZE) { sdlr_flush(); }
-
-  size_t mu_Color_size = sizeof(mu_Color);
-  
-  int texvert_idx = buf_idx *  8;
-  int   color_idx = buf_idx * 4 * mu_Color_size;
-  int element_idx = buf_idx *  4;
-  int   index_idx = buf_idx *  6;
-  buf_idx++;
-
-  /* update texture buffer */
-  float x = src.x / (float) ATLAS_WIDTH;
-  float y = src.y / (float) ATLAS_HEIGHT;
-  float w = src.w / (float) ATLAS_WIDTH;
-  float h = src.h / (float) ATLAS_HEIGHT;
-  tex_buf[texvert_idx + 0] = x;
-  tex_buf[texvert_idx + 1] = y;
-  tex_buf[texvert_idx + 2] = x + w;
-  tex_buf[texvert_idx + 3] = y;
-  tex_buf[texvert_idx + 4] = x;
-  tex_buf[texvert_idx + 5] = y + h;
-  tex_buf[texvert_idx + 6] = x + w;
-  tex_buf[texvert_idx + 7] = y + h;
-
-  /* update vertex buffer */
-  vert_buf[texvert_idx + 0] = dst.x;
-  vert_buf[texvert_idx + 1] = dst.y;
-  vert_buf[texvert_idx + 2] = dst.x + dst.w;
-  vert_buf[texvert_idx + 3] = dst.y;
-  vert_buf[texvert_idx + 4] = dst.x;
-  vert_buf[texvert_idx + 5] = dst.y + dst.h;
-  vert_buf[texvert_idx + 6] = dst.x + dst.w;
-  vert_buf[texvert_idx + 7] = dst.y + dst.h;
-
-  /* update color buffer */
-  memcpy(color_buf + (color_idx + 0 * mu_Color_size), &color, mu_Color_size);
-  memcpy(color_buf + (color_idx + 1 * mu_Color_size), &color, mu_Color_size);
-  memcpy(color_buf + (color_idx + 2 * mu_Color_size), &color, mu_Color_size);
-  memcpy(color_buf + (color_idx + 3 * mu_Color_size), &color, mu_Color_size);
-
-  /* update index buffer */
-  index_buf[index_idx++] = element_idx + 0;
-  index_buf[index_idx++] = element_idx + 1;
-  index_buf[index_idx++] = element_idx + 2;
-  index_buf[index_idx++] = element_idx + 2;
-  index_buf[index_idx++] = element_idx + 3;
-  index_buf[index_idx++] = element_idx + 1;
+static mu_Rect intersect(mu_Rect a, mu_Rect b) {
+  int x = mu_max(a.x, b.x), y = mu_max(a.y, b.y);
+  int x2 = mu_min(a.x + a.w, b.x + b.w), y2 = mu_min(a.y + a.h, b.y + b.h);
+
+  return mu_rect(x, y, mu_max(x2 - x, 0), mu_max(y2 - y, 0));
+}
+
+/* trims a quad, x0 y0 x1 y1, to the clip rect and moves its texture
+** coordinates along. false when nothing of it is left */
+static bool clip_quad(float *pos, float *uv) {
+  float cx0 = clip_rect.x, cy0 = clip_rect.y;
+  float cx1 = clip_rect.x + clip_rect.w, cy1 = clip_rect.y + clip_rect.h;
+
+  if (pos[0] >= cx1 || pos[2] <= cx0 || pos[1] >= cy1 || pos[3] <= cy0) {
+    stats.culled++;
+    return false;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    float lo = i == 0 ? cx0 : cy0, hi = i == 0 ? cx1 : cy1;
+    float scale = (uv[i + 2] - uv[i]) / (pos[i + 2] - pos[i]);
+
+    if (pos[i] < lo) {
+      uv[i] += (lo - pos[i]) * scale;
+      pos[i] = lo;
+    }
+
+    if (pos[i + 2] > hi) {
+      uv[i + 2] -= (pos[i + 2] - hi) * scale;
+      pos[i + 2] = hi;
+    }
+  }
+
+  return true;
+}
+
+static void emit_quad(const float *pos, const float *uv, SDL_Color c) {
+  reserve_quad();
+
+  SDL_Vertex *v = vert_buf + buf_idx++ * 4;
+
+  v[0] = (SDL_Vertex) { { pos[0], pos[1] }, c, { uv[0], uv[1] } };
+  v[1] = (SDL_Vertex) { { pos[2], pos[1] }, c, { uv[2], uv[1] } };
+  v[2] = (SDL_Vertex) { { pos[0], pos[3] }, c, { uv[0], uv[3] } };
+  v[3] = (SDL_Vertex) { { pos[2], pos[3] }, c, { uv[2], uv[3] } };
+}
+
+static void push_quad(mu_Rect dst, const float *uv, mu_Color color) {
+  float p[4] = { dst.x, dst.y, dst.x + dst.w, dst.y + dst.h };
+  float t[4] = { uv[0], uv[1], uv[2], uv[3] };
+
+  if (clip_quad(p, t)) {
+    emit_quad(p, t, (SDL_Color) { color.r, color.g, color.b, color.a });
+  }
+}
+
+/* ascii comes from the built-in font, anything else from the glyph cache or '?' */
+static void find_glyph(int codepoint, mu_Rect *src, const float **uv) {
+  if (codepoint < 128) {
+    *src = atlas[ATLAS_FONT + codepoint];
+    *uv = atlas_uv[ATLAS_FONT + codepoint];
+    return;
+  }
+
+  const glyph *g = glyphs_get(codepoint, frame_count, sdlr_flush);
+
+  if (g == NULL) {
+    find_glyph('?', src, uv);
+    return;
+  }
+
+  *src = mu_rect(g->rect.x, g->rect.y, g->rect.w, g->rect.h);
+  *uv = g->uv;
+}
+
+static unsigned hash_text(const char *text) {
+  unsigned h = 2166136261;
+
+  for (const char *p = text; *p; p++) {
+    h = (h ^ (unsigned char)*p) * 16777619;
+  }
+
+  return h;
 }
 
 int sdlr_get_text_width(const char *text, int len) {
   int res = 0;
-  for (const char *p = text; *p && len--; p++) {
-    if ((*p & 0xc0) == 0x80) { continue; }
-    int chr = mu_min((unsigned char) *p, 127);
-    res += atlas[ATLAS_FONT + chr].w;
+  mu_Rect src;
+  const float *uv;
+
+  /* a whole string that was drawn already has its width in the cache */
+  if (strnlen(text, len) < (size_t) len || text[len] == '\0') {
+    unsigned hash = hash_text(text);
+
+    for (int i = text_buckets[hash % TEXT_BUCKETS]; i != -1; i = text_runs[i].next) {
+      const text_run *run = &text_runs[i];
+
+      if (run->hash == hash && run->generation == glyphs_generation() && strcmp(run->text, text) == 0) {
+        return run->width;
+      }
+    }
+  }
+
+  for (const char *p = text; *p && p - text < len; ) {
+    find_glyph(glyphs_decode(&p), &src, &uv);
+    res += src.w;
   }
+
   return res;
 }
 
+/* measures `text` once for every character boundary: offsets[i] bytes are
+** widths[i] pixels wide, starting with the empty prefix. returns how many
+** boundaries were filled, at most `max` */
+int sdlr_get_text_prefixes(const char *text, int len, int *offsets, int *widths, int max) {
+  int count = 0, res = 0;
+  mu_Rect src;
+  const float *uv;
+  const char *p = text;
+
+  while (count < max) {
+    offsets[count] = p - text;
+    widths[count++] = res;
+
+    if (!*p || p - text >= len) { break; }
+
+    find_glyph(glyphs_decode(&p), &src, &uv);
+    res += src.w;
+  }
+
+  return count;
+}
+
 int sdlr_get_text_height(void) {
   return 18;
 }
 
 void sdlr_draw_rect(mu_Rect rect, mu_Color color) {
-  push_quad(rect, atlas[ATLAS_WHITE], color);
+  push_quad(rect, atlas_uv[ATLAS_WHITE], color);
+}
+
+static void draw_spectrogram(mu_Rect rect) {
+  mu_Rect visible = intersect(rect, clip_rect);
+
+  if (spectrogram == NULL || visible.w == 0 || visible.h == 0) { return; }
+
+  /* keep the order with the quads queued so far */
+  sdlr_flush();
+
+  int older = SPECTROGRAM_COLUMNS - spectrogram_head;
+  int split = rect.w * older / SPECTROGRAM_COLUMNS;
+
+  SDL_Rect src1 = { spectrogram_head, 0, older, spectrogram_rows };
+  SDL_Rect dst1 = { rect.x, rect.y, split, rect.h };
+  SDL_Rect src2 = { 0, 0, spectrogram_head, spectrogram_rows };
+  SDL_Rect dst2 = { rect.x + split, rect.y, rect.w - split, rect.h };
+
+  /* drawn on its own anyway, so the gpu clips it */
+  SDL_Rect clip = { visible.x, visible.y, visible.w, visible.h };
+  SDL_RenderSetClipRect(renderer, &clip);
+
+  SDL_RenderCopy(renderer, spectrogram, &src1, &dst1);
+  if (spectrogram_head > 0) {
+    SDL_RenderCopy(renderer, spectrogram, &src2, &dst2);
+  }
+
+  SDL_RenderSetClipRect(renderer, NULL);
+}
+
+void sdlr_push_spectrogram_column(const float *levels, int count, float min_db) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  if (count != spectrogram_rows) {
+    SDL_DestroyTexture(spectrogram);
+    spectrogram = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, SPECTROGRAM_COLUMNS, count);
+    spectrogram_rows = count;
+    spectrogram_head = 0;
+
+    /* start from a black image instead of whatever the driver hands out */
+    for (int x = 0; x < SPECTROGRAM_COLUMNS; x++) {
+      SDL_Rect column = { x, 0, 1, count };
+      unsigned char *pixels;
+      int pitch;
+
+      if (SDL_LockTexture(spectrogram, &column, (void**)&pixels, &pitch) == 0) {
+        for (int y = 0; y < count; y++) memcpy(pixels + y * pitch, spectrogram_lut[0], 4);
+        SDL_UnlockTexture(spectrogram);
+      }
+    }
+  }
+
+  SDL_Rect column = { spectrogram_head, 0, 1, count };
+  unsigned char *pixels;
+  int pitch;
+
+  if (SDL_LockTexture(spectrogram, &column, (void**)&pixels, &pitch) == 0) {
+    /* highest band at the top */
+    for (int y = 0; y < count; y++) {
+      float level = (levels[count - 1 - y] - min_db) / -min_db;
+      int idx = mu_clamp(level * 255, 0, 255);
+      memcpy(pixels + y * pitch, spectrogram_lut[idx], 4);
+    }
+
+    SDL_UnlockTexture(spectrogram);
+  }
+
+  spectrogram_head = (spectrogram_head + 1) % SPECTROGRAM_COLUMNS;
+
+  stats.upload_ms += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+const sdlr_stats *sdlr_get_stats(void) {
+  return &last_stats;
+}
+
+/* of the display the window is on, 0 when unknown */
+int sdlr_get_refresh_rate(void) {
+  SDL_DisplayMode mode;
+
+  if (window == NULL) {
+    return 0;
+  }
+
+  int display = SDL_GetWindowDisplayIndex(window);
+
+  if (display < 0 || SDL_GetCurrentDisplayMode(display, &mode) != 0) {
+    return 0;
+  }
+
+  return mode.refresh_rate;
 }
 
 void sdlr_draw_icon(int id, mu_Rect rect, mu_Color color) {
+  if (id == SDLR_ICON_SPECTROGRAM) {
+    draw_spectrogram(rect);
+    return;
+  }
+
   mu_Rect src = atlas[id];
   int x = rect.x + (rect.w - src.w) / 2;
   int y = rect.y + (rect.h - src.h) / 2;
-  push_quad(mu_rect(x, y, src.w, src.h), src, color);
+  push_quad(mu_rect(x, y, src.w, src.h), atlas_uv[id], color);
+}
+
+void sdlr_draw_quads(const mu_Rect *rects, int count, mu_Color color) {
+  for (int i = 0; i < count; i++) {
+    push_quad(rects[i], atlas_uv[ATLAS_WHITE], color);
+  }
+}
+
+static text_run *find_run(const char *text, mu_Color color, unsigned hash) {
+  for (int i = text_buckets[hash % TEXT_BUCKETS]; i != -1; i = text_runs[i].next) {
+    text_run *run = &text_runs[i];
+
+    if (run->hash == hash && memcmp(&run->color, &color, sizeof(color)) == 0 &&
+        strcmp(run->text, text) == 0) {
+      return run;
+    }
+  }
+
+  return NULL;
+}
+
+static void link_run(int index) {
+  text_runs[index].newer = -1;
+  text_runs[index].older = newest_run;
+
+  if (newest_run != -1) text_runs[newest_run].newer = index; else oldest_run = index;
+  newest_run = index;
+}
+
+static void unlink_run(int index) {
+  text_run *run = &text_runs[index];
+
+  if (run->newer != -1) text_runs[run->newer].older = run->older; else newest_run = run->older;
+  if (run->older != -1) text_runs[run->older].newer = run->newer; else oldest_run = run->newer;
+}
+
+/* moves a run to the front of the drawing order */
+static void touch_run(int index) {
+  if (index == newest_run) return;
+
+  unlink_run(index);
+  link_run(index);
+}
+
+/* takes a free entry, or the least recently drawn one out of its bucket.
+** either way it comes back first in the drawing order */
+static int take_run(void) {
+  if (text_run_count < TEXT_CACHE_SIZE) {
+    int index = text_run_count++;
+
+    link_run(index);
+    return index;
+  }
+
+  int oldest = oldest_run;
+  int *link = &text_buckets[text_runs[oldest].hash % TEXT_BUCKETS];
+
+  while (*link != oldest) {
+    link = &text_runs[*link].next;
+  }
+
+  *link = text_runs[oldest].next;
+  touch_run(oldest);
+
+  return oldest;
+}
+
+/* a glyph evicted part way moves the ones placed before it, which takes
+** one more pass. a frame needing more than the whole atlas gets no more */
+static void layout_run(text_run *run) {
+  SDL_Color c = { run->color.r, run->color.g, run->color.b, run->color.a };
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    run->generation = glyphs_generation();
+    run->glyphs = 0;
+    run->width = 0;
+
+    for (const char *p = run->text; *p; ) {
+      mu_Rect src;
+      const float *uv;
+
+      find_glyph(glyphs_decode(&p), &src, &uv);
+
+      float x0 = run->width, x1 = run->width + src.w;
+      float y0 = (GLYPH_HEIGHT - src.h) / 2, y1 = y0 + src.h;
+
+      SDL_Vertex *v = run->vertices + run->glyphs++ * 4;
+      v[0] = (SDL_Vertex) { { x0, y0 }, c, { uv[0], uv[1] } };
+      v[1] = (SDL_Vertex) { { x1, y0 }, c, { uv[2], uv[1] } };
+      v[2] = (SDL_Vertex) { { x0, y1 }, c, { uv[0], uv[3] } };
+      v[3] = (SDL_Vertex) { { x1, y1 }, c, { uv[2], uv[3] } };
+
+      run->width += src.w;
+    }
+
+    if (run->generation == glyphs_generation()) break;
+  }
+}
+
+static text_run *build_run(const char *text, mu_Color color, unsigned hash) {
+  int index = take_run();
+  text_run *run = &text_runs[index];
+
+  int len = strlen(text);
+
+  /* a run has at most one glyph per byte */
+  if (len >= run->text_cap) {
+    free(run->text);
+    free(run->vertices);
+    run->text_cap = len + 1;
+    run->text = malloc(run->text_cap);
+    run->vertices = malloc(len * 4 * sizeof(SDL_Vertex));
+    stats.allocations += 2;
+  }
+
+  memcpy(run->text, text, len + 1);
+  run->hash = hash;
+  run->color = color;
+
+  layout_run(run);
+
+  run->next = text_buckets[hash % TEXT_BUCKETS];
+  text_buckets[hash % TEXT_BUCKETS] = index;
+
+  return run;
 }
 
 void sdlr_draw_text(const char *text, mu_Vec2 pos, mu_Color color) {
-  mu_Rect dst = { pos.x, pos.y, 0, 0 };
-  for (const char *p = text; *p; p++) {
-    if ((*p & 0xc0) == 0x80) { continue; }
-    int chr = mu_min((unsigned char) *p, 127);
-    mu_Rect src = atlas[ATLAS_FONT + chr];
-    dst.w = src.w;
-    dst.h = src.h;
-    push_quad(dst, src, color);
-    dst.x += dst.w;
+  unsigned hash = hash_text(text);
+  text_run *run = find_run(text, color, hash);
+
+  if (run != NULL && run->generation == glyphs_generation()) {
+    stats.text_hits++;
+  } else if (run != NULL) {
+    /* its glyphs moved in the atlas */
+    stats.text_misses++;
+    layout_run(run);
+  } else {
+    stats.text_misses++;
+    run = build_run(text, color, hash);
+  }
+
+  touch_run(run - text_runs);
+
+  mu_Rect bounds = mu_rect(pos.x, pos.y, run->width, GLYPH_HEIGHT);
+
+  if (bounds.x >= clip_rect.x + clip_rect.w || bounds.x + bounds.w <= clip_rect.x ||
+      bounds.y >= clip_rect.y + clip_rect.h || bounds.y + bounds.h <= clip_rect.y) {
+    stats.culled += run->glyphs;
+    return;
+  }
+
+  if (bounds.x < clip_rect.x || bounds.y < clip_rect.y ||
+      bounds.x + bounds.w > clip_rect.x + clip_rect.w ||
+      bounds.y + bounds.h > clip_rect.y + clip_rect.h) {
+    /* partly clipped, each glyph is trimmed or dropped on its own. glyphs
+    ** run left to right, so the rest are gone once one starts past the edge */
+    for (int i = 0; i < run->glyphs; i++) {
+      const SDL_Vertex *v = run->vertices + i * 4;
+
+      if (v[0].position.x + pos.x >= clip_rect.x + clip_rect.w) {
+        stats.culled += run->glyphs - i;
+        break;
+      }
+
+      float p[4] = { v[0].position.x + pos.x, v[0].position.y + pos.y, v[3].position.x + pos.x, v[3].position.y + pos.y };
+      float t[4] = { v[0].tex_coord.x, v[0].tex_coord.y, v[3].tex_coord.x, v[3].tex_coord.y };
+
+      if (clip_quad(p, t)) emit_quad(p, t, v[0].color);
+    }
+
+    return;
+  }
+
+  /* copied into the batch as a whole, split only where a batch fills up */
+  for (int i = 0; i < run->glyphs; ) {
+    reserve_quad();
+
+    int count = mu_min(run->glyphs - i, buf_cap - buf_idx);
+    SDL_Vertex *v = vert_buf + buf_idx * 4;
+
+    memcpy(v, run->vertices + i * 4, count * 4 * sizeof(SDL_Vertex));
+
+    for (int k = 0; k < count * 4; k++) {
+      v[k].position.x += pos.x;
+      v[k].position.y += pos.y;
+    }
+
+    buf_idx += count;
+    i += count;
   }
 }
 
 void sdlr_set_clip_rect(mu_Rect rect) {
-  SDL_Rect clip_rect = { rect.x, height - (rect.y + rect.h), rect.w, rect.h };
-  SDL_RenderSetClipRect(renderer, &clip_rect);
+  clip_rect = intersect(rect, damage_rect);
+}
+
+/* limits drawing to `rect` until the next present, call before sdlr_clear.
+** a frame with several damaged areas is drawn once into each */
+void sdlr_set_damage(mu_Rect rect) {
+  damage_rect = clip_rect = rect;
+}
+
+/* jumps are left to mu_next_command, or already followed in a recording */
+void sdlr_draw_command(mu_Command *cmd) {
+  switch (cmd->type) {
+    case MU_COMMAND_TEXT: sdlr_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color); break;
+    case MU_COMMAND_RECT: sdlr_draw_rect(cmd->rect.rect, cmd->rect.color); break;
+    case MU_COMMAND_ICON: sdlr_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
+    case MU_COMMAND_CLIP: sdlr_set_clip_rect(cmd->clip.rect); break;
+    case MU_COMMAND_QUADS: sdlr_draw_quads(cmd->quads.rects, cmd->quads.count, cmd->quads.color); break;
+  }
 }
 
 void sdlr_clear(mu_Color clr) {
+  update_size();
+
+  if (target_w != width || target_h != height) {
+    SDL_DestroyTexture(target);
+    target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+    target_w = width;
+    target_h = height;
+
+    /* a new target holds nothing worth keeping */
+    damage_rect = clip_rect = unclipped;
+  }
+
+  /* without render targets every frame is drawn whole, straight to the screen */
+  if (target == NULL) {
+    damage_rect = clip_rect = unclipped;
+  }
+
+  SDL_SetRenderTarget(renderer, target);
+
+  mu_Rect r = intersect(damage_rect, mu_rect(0, 0, width, height));
+  SDL_Rect area = { r.x, r.y, r.w, r.h };
+
   SDL_SetRenderDrawColor(renderer, clr.r, clr.g, clr.b, clr.a);
-  SDL_RenderClear(renderer);
+  SDL_RenderFillRect(renderer, &area);
+
+  stats.damage_pixels += r.w * r.h;
 }
 
 void sdlr_present(void) {
   sdlr_flush();
+
+  if (target != NULL) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, target, NULL, NULL);
+  }
+
+  SDL_RenderPresent(renderer);
+
+  damage_rect = clip_rect = unclipped;
+
+  stats.glyph_misses = glyphs_rasterized() - rasterized_before;
+  rasterized_before = glyphs_rasterized();
+
+  last_stats = stats;
+  memset(&stats, 0, sizeof(stats));
+
+  frame_count++;
+}
+
+static unsigned long png_crc(unsigned long crc, const unsigned char *data, size_t len) {
+  static unsigned long table[256];
+
+  if (table[1] == 0) {
+    for (unsigned long n = 0; n < 256; n++) {
+      unsigned long c = n;
+      for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+  }
+
+  crc ^= 0xffffffff;
+  for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+  return crc ^ 0xffffffff;
+}
+
+static void png_u32(unsigned char *out, unsigned long v) {
+  out[0] = v >> 24; out[1] = v >> 16; out[2] = v >> 8; out[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const unsigned char *data, size_t len) {
+  unsigned char head[8];
+
+  png_u32(head, len);
+  memcpy(head + 4, type, 4);
+  fwrite(head, 1, 8, f);
+  fwrite(data, 1, len, f);
+
+  unsigned char crc[4];
+  png_u32(crc, png_crc(png_crc(0, (const unsigned char*)type, 4), data, len));
+  fwrite(crc, 1, 4, f);
+}
+
+/*
+** writes what has been drawn so far as an rgba png. the image data is
+** deflate with stored blocks only, it is meant for tests, not for size
+*/
+bool sdlr_save_png(const char *path) {
+  int w, h;
+
+  sdlr_flush();
+
+  if (SDL_GetRendererOutputSize(renderer, &w, &h) != 0) {
+    return false;
+  }
+
+  /* every row starts with its filter type, 0 for none */
+  size_t row = w * 4 + 1, raw_len = row * h;
+  unsigned char *raw = malloc(raw_len);
+  unsigned char *pixels = malloc(w * h * 4);
+
+  if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels, w * 4) != 0) {
+    free(raw);
+    free(pixels);
+    return false;
+  }
+
+  for (int y = 0; y < h; y++) {
+    raw[y * row] = 0;
+    memcpy(raw + y * row + 1, pixels + y * w * 4, w * 4);
+  }
+
+  free(pixels);
+
+  size_t blocks = (raw_len + 65534) / 65535;
+  size_t idat_len = 2 + blocks * 5 + raw_len + 4;
+  unsigned char *idat = malloc(idat_len), *p = idat;
+
+  *p++ = 0x78; *p++ = 0x01;
+
+  for (size_t done = 0; done < raw_len; ) {
+    size_t len = raw_len - done < 65535 ? raw_len - done : 65535;
+
+    *p++ = done + len == raw_len;
+    *p++ = len; *p++ = len >> 8;
+    *p++ = ~len; *p++ = ~len >> 8;
+    memcpy(p, raw + done, len);
+
+    p += len;
+    done += len;
+  }
+
+  unsigned long a = 1, b = 0;
+
+  for (size_t i = 0; i < raw_len; i++) {
+    a = (a + raw[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+
+  png_u32(p, (b << 16) | a);
+  free(raw);
+
+  FILE *f = fopen(path, "wb");
+
+  if (f == NULL) {
+    free(idat);
+    return false;
+  }
+
+  unsigned char ihdr[13];
+  png_u32(ihdr, w);
+  png_u32(ihdr + 4, h);
+  /* 8 bit rgba, no interlace */
+  ihdr[8] = 8; ihdr[9] = 6; ihdr[10] = 0; ihdr[11] = 0; ihdr[12] = 0;
+
+  fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+  png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+  png_chunk(f, "IDAT", idat, idat_len);
+  png_chunk(f, "IEND", NULL, 0);
+
+  free(idat);
+
+  return fclose(f) == 0;
 }
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+#include <microui.h>
+#include <renderer.h>
+#include <recording.h>
+
+/*
+** sap-replay draws a recording made with SAP_RECORD through the renderer
+** as fast as it can and prints the throughput. it renders headless unless
+** given -w, and never waits for vsync. frames are limited to the damage
+** they were recorded with, -f draws every one whole.
+*/
+
+typedef struct {
+  long offset;
+  int size;
+  mu_Rect damage[DAMAGE_MAX_RECTS];
+  int damage_count;
+} replay_frame;
+
+static int compare_ms(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+
+  return (x > y) - (x < y);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: sap-replay [-w] [-f] recording [passes]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool windowed = false, full = false;
+  int arg = 1;
+
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-w") == 0) {
+      windowed = true;
+    } else if (strcmp(argv[arg], "-f") == 0) {
+      full = true;
+    } else {
+      usage();
+    }
+  }
+
+  if (arg >= argc) usage();
+
+  const char *path = argv[arg++];
+  int passes = arg < argc ? atoi(argv[arg]) : 1;
+
+  if (passes < 1) usage();
+
+  FILE *f = fopen(path, "rb");
+
+  if (f == NULL || !recording_check_header(f)) {
+    fprintf(stderr, "sap-replay: %s is not a recording\n", path);
+    return EXIT_FAILURE;
+  }
+
+  /* everything is loaded up front so the timed loop does no io */
+  char *commands = NULL;
+  long used = 0, cap = 0;
+  replay_frame *frames = NULL;
+  int frame_count = 0, frame_cap = 0;
+
+  char *buffer = NULL;
+  int buffer_cap = 0;
+  recording_input input;
+  mu_Rect damage[DAMAGE_MAX_RECTS];
+  int damage_count, size;
+
+  while (recording_read_frame(f, &input, damage, &damage_count, &buffer, &buffer_cap, &size)) {
+    if (frame_count == frame_cap) {
+      frame_cap = frame_cap ? frame_cap * 2 : 256;
+      frames = realloc(frames, frame_cap * sizeof(replay_frame));
+    }
+
+    while (used + size > cap) {
+      cap = cap ? cap * 2 : 1 << 20;
+      commands = realloc(commands, cap);
+    }
+
+    memcpy(commands + used, buffer, size);
+    replay_frame *frame = &frames[frame_count++];
+    frame->offset = used;
+    frame->size = size;
+    frame->damage_count = damage_count;
+    memcpy(frame->damage, damage, sizeof(damage));
+    used += size;
+  }
+
+  fclose(f);
+  free(buffer);
+
+  if (frame_count == 0) {
+    fprintf(stderr, "sap-replay: %s has no frames\n", path);
+    return EXIT_FAILURE;
+  }
+
+  if (!windowed) {
+    SDL_setenv("SAP_HEADLESS", "1", 1);
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+  }
+
+  SDL_setenv("SAP_NOVSYNC", "1", 1);
+
+  SDL_Init(SDL_INIT_VIDEO);
+  sdlr_init();
+
+  int total = frame_count * passes;
+  double *frame_ms = malloc(total * sizeof(double));
+  long long quads = 0, batches = 0, text_hits = 0, text_misses = 0, damage_pixels = 0;
+  double freq = SDL_GetPerformanceFrequency() / 1000.0;
+
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  for (int i = 0; i < total; i++) {
+    const replay_frame *frame = &frames[i % frame_count];
+    Uint64 frame_start = SDL_GetPerformanceCounter();
+
+    /* the first frame of a pass is drawn whole, later ones only where they changed */
+    bool whole = full || i % frame_count == 0;
+
+    for (int d = 0; d < (whole ? 1 : frame->damage_count); d++) {
+      if (!whole) sdlr_set_damage(frame->damage[d]);
+      sdlr_clear(mu_color(10, 10, 23, 255));
+
+      for (int at = 0; at < frame->size; ) {
+        mu_Command *cmd = (mu_Command*)(commands + frame->offset + at);
+        sdlr_draw_command(cmd);
+        at += cmd->base.size;
+      }
+    }
+
+    sdlr_present();
+
+    frame_ms[i] = (SDL_GetPerformanceCounter() - frame_start) / freq;
+
+    const sdlr_stats *stats = sdlr_get_stats();
+    quads += stats->quads;
+    batches += stats->batches;
+    text_hits += stats->text_hits;
+    text_misses += stats->text_misses;
+    damage_pixels += stats->damage_pixels;
+  }
+
+  double seconds = (SDL_GetPerformanceCounter() - start) / freq / 1000.0;
+
+  qsort(frame_ms, total, sizeof(double), compare_ms);
+
+  printf("%s: %d frames x %d passes, %s, %s\n", path, frame_count, passes,
+    windowed ? "window" : "headless", full ? "full redraw" : "damage only");
+  printf("%.1f frames/s, %.2f Mquads/s\n", total / seconds, quads / seconds / 1e6);
+  printf("frame ms p50 %.3f, p99 %.3f, max %.3f\n",
+    frame_ms[total / 2], frame_ms[total * 99 / 100], frame_ms[total - 1]);
+  printf("%.1f quads, %.2f batches, %.0f pixels redrawn per frame, text cache hit rate %.1f%%\n",
+    (double)quads / total, (double)batches / total, (double)damage_pixels / total,
+    text_hits + text_misses > 0 ? 100.0 * text_hits / (text_hits + text_misses) : 0.0);
+
+  free(frame_ms);
+  free(frames);
+  free(commands);
+
+  SDL_Quit();
+
+  return EXIT_SUCCESS;
+}
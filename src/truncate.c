@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <microui.h>
+#include <renderer.h>
+#include <truncate.h>
+
+/*
+** file window names are cut to the width of their container with an
+** ellipsis. the cut is remembered per name and width in a direct mapped
+** cache, so a name is only measured again when the window is resized. the
+** rows are read from the directory every frame and have nowhere to keep
+** their cut themselves, so the name is hashed to find it.
+*/
+
+/* a power of two */
+#define TRUNCATED_CACHE_SIZE 1024
+
+typedef struct {
+  uint64_t hash;
+  int width;
+  /* bytes kept before the ellipsis, -1 when the whole name fits */
+  int len;
+  int text_width;
+} truncated_text;
+
+static truncated_text truncated[TRUNCATED_CACHE_SIZE];
+
+/* eight bytes a step, names are hashed for every row of every frame. the
+** shifts fold the high bits down, the cache is indexed by the low ones */
+static uint64_t hash_name(const char *text, int len) {
+  uint64_t h = 14695981039346656037ULL ^ len;
+
+  for (; len >= 8; text += 8, len -= 8) {
+    uint64_t word;
+    memcpy(&word, text, 8);
+
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+  }
+
+  for (; len > 0; text++, len--) {
+    h = (h ^ (unsigned char)*text) * 1099511628211ULL;
+  }
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+/* cuts `text` in place to fit the current container and returns its width */
+int truncate_text(mu_Context *ctx, char *text) {
+  static const char ellipsis[] = "...";
+
+  int width = mu_get_current_container(ctx)->rect.w - 15;
+  int len = strlen(text);
+  uint64_t hash = hash_name(text, len);
+  truncated_text *entry = &truncated[hash & (TRUNCATED_CACHE_SIZE - 1)];
+
+  if (entry->hash != hash || entry->width != width) {
+    /* names and paths are shorter than 1024 bytes */
+    int offsets[1024 + 1], widths[1024 + 1];
+    int count = sdlr_get_text_prefixes(text, len, offsets, widths, 1024 + 1);
+
+    entry->hash = hash;
+    entry->width = width;
+
+    if (widths[count - 1] <= width) {
+      entry->len = -1;
+      entry->text_width = widths[count - 1];
+    } else {
+      int dots = sdlr_get_text_width(ellipsis, sizeof(ellipsis) - 1);
+      int low = 0, high = count - 1;
+
+      /* the longest prefix that fits next to the ellipsis and leaves room
+      ** for its bytes in `text` */
+      while (low < high) {
+        int mid = (low + high + 1) / 2;
+
+        if (widths[mid] + dots <= width && offsets[mid] + (int)sizeof(ellipsis) - 1 <= len) {
+          low = mid;
+        } else {
+          high = mid - 1;
+        }
+      }
+
+      /* too short to hold the ellipsis, left whole */
+      if (offsets[low] + (int)sizeof(ellipsis) - 1 > len) {
+        entry->len = -1;
+        entry->text_width = widths[count - 1];
+      } else {
+        entry->len = offsets[low];
+        entry->text_width = widths[low] + dots;
+      }
+    }
+  }
+
+  if (entry->len >= 0) {
+    memcpy(text + entry->len, ellipsis, sizeof(ellipsis));
+  }
+
+  return entry->text_width;
+}
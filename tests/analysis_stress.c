@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+
+#include <analysis.h>
+
+/*
+** hammers every handoff of the analysis thread at once, built with
+** -fsanitize=thread: one thread plays the audio callback and pushes as fast
+** as it can, overrunning the ring, another keeps reconfiguring the spectrum
+** and the main thread reads frames like the ui does. besides the races
+** ThreadSanitizer reports, a frame that changes while the reader holds it
+** or that mixes up two configurations counts as a failure.
+*/
+
+#define SAMPLE_RATE 44100
+#define PUSH_FRAMES 1024
+#define RUN_SECONDS 2
+
+static const analysis_config configs[] = {
+  { 32, 40, 16000, 0, 0.01f, 20.0f },
+  { 64, 20, 20000, 0.005f, 0.3f, 10.0f },
+  { 128, 60, 11000, 0.02f, 0.1f, 40.0f },
+};
+
+#define CONFIG_COUNT (int)(sizeof(configs) / sizeof(configs[0]))
+
+static atomic_int stop;
+static atomic_int pushes;
+static atomic_int reconfigures;
+
+static int producer(void *data) {
+  int16_t samples[PUSH_FRAMES * 2];
+  int offset = 0;
+
+  while (!atomic_load(&stop)) {
+    for (int i = 0; i < PUSH_FRAMES; i++) {
+      int16_t sample = 20000 * sinf((offset + i) * 0.05f);
+
+      /* now and then a clipped buffer, so the clip counters move too */
+      if (offset % (PUSH_FRAMES * 64) == 0) sample = i & 1 ? 32767 : -32768;
+
+      samples[2 * i] = sample;
+      samples[2 * i + 1] = -sample;
+    }
+
+    analysis_push(samples, PUSH_FRAMES);
+    offset += PUSH_FRAMES;
+    atomic_fetch_add(&pushes, 1);
+  }
+
+  return 0;
+}
+
+static int configurer(void *data) {
+  for (int i = 0; !atomic_load(&stop); i++) {
+    analysis_configure(&configs[i % CONFIG_COUNT]);
+    atomic_fetch_add(&reconfigures, 1);
+
+    /* faster than any slider drag, slow enough to leave the others cpu time */
+    SDL_Delay(1);
+  }
+
+  return 0;
+}
+
+static double elapsed(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(void) {
+  analysis_init(SAMPLE_RATE, &configs[0], 0);
+
+  SDL_Thread *threads[2] = {
+    SDL_CreateThread(producer, "producer", NULL),
+    SDL_CreateThread(configurer, "configurer", NULL),
+  };
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int failures = 0;
+  int reads = 0, fresh = 0;
+  unsigned serial = 0;
+  int clipped = 0;
+  analysis_frame held;
+
+  while (elapsed(&start) < RUN_SECONDS && failures < 10) {
+    const analysis_frame *frame = analysis_latest();
+    held = *frame;
+    reads++;
+
+    bool known = false;
+    for (int c = 0; c < CONFIG_COUNT; c++) {
+      known |= held.bars == configs[c].bars;
+    }
+
+    for (int i = 0; i < held.bars && known; i++) {
+      known = isfinite(held.levels[i]) && isfinite(held.peaks[i]);
+    }
+
+    if (!known || held.serial < serial || held.clipped[0] < clipped) {
+      printf("FAIL frame %u: %d bars, serial after %u, %d clips after %d\n",
+        held.serial, held.bars, serial, held.clipped[0], clipped);
+      failures++;
+    }
+
+    fresh += held.serial != serial;
+    serial = held.serial;
+    clipped = held.clipped[0];
+
+    /* the analysis thread must never write the frame the reader holds */
+    SDL_Delay(0);
+
+    if (memcmp(frame, &held, sizeof(held)) != 0) {
+      printf("FAIL frame %u changed while held\n", held.serial);
+      failures++;
+    }
+  }
+
+  atomic_store(&stop, 1);
+
+  for (int i = 0; i < 2; i++) {
+    SDL_WaitThread(threads[i], NULL);
+  }
+
+  analysis_shutdown();
+
+  printf("%d pushes, %d reconfigures, %d reads, %d fresh frames, %d failures\n",
+    atomic_load(&pushes), atomic_load(&reconfigures), reads, fresh, failures);
+
+  return failures > 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <fft.h>
+
+/*
+** checks fft_power() against a double precision dft for every power of two
+** from 8 to 8192 points and prints what one transform costs at 1024, 2048
+** and 4096 points.
+*/
+
+static int failures = 0;
+
+static unsigned random_state = 12345;
+
+static float random_sample(void) {
+  random_state = random_state * 1103515245 + 12345;
+  return (int)(random_state >> 16 & 0xffff) / 32768.0f - 1.0f;
+}
+
+static void fill(float *input, int size) {
+  for (int i = 0; i < size; i++) {
+    input[i] = 0.5f * sinf(i * 0.37f) + 0.3f * cosf(i * 1.9f) + 0.2f * random_sample();
+  }
+}
+
+static void test_size(int size) {
+  float *input = malloc(size * sizeof(float));
+  float *power = malloc((size / 2 + 1) * sizeof(float));
+  fft_plan *plan = fft_create(size);
+
+  fill(input, size);
+  fft_power(plan, input, power);
+
+  double max_error = 0, max_power = 0;
+
+  for (int k = 0; k <= size / 2; k++) {
+    double re = 0, im = 0;
+
+    for (int i = 0; i < size; i++) {
+      re += input[i] * cos(2 * M_PI * k * i / size);
+      im -= input[i] * sin(2 * M_PI * k * i / size);
+    }
+
+    double ref = re * re + im * im;
+
+    max_error = fmax(max_error, fabs(ref - power[k]));
+    max_power = fmax(max_power, ref);
+  }
+
+  /* float rounding grows with log2(size), this leaves a wide margin */
+  if (max_error > 1e-5 * max_power) {
+    printf("FAIL %d points: error %g of %g\n", size, max_error, max_power);
+    failures++;
+  }
+
+  fft_destroy(plan);
+  free(power);
+  free(input);
+}
+
+static void bench(int size) {
+  float *input = malloc(size * sizeof(float));
+  float *power = malloc((size / 2 + 1) * sizeof(float));
+  fft_plan *plan = fft_create(size);
+
+  fill(input, size);
+
+  struct timespec start, end;
+  double checksum = 0;
+  int runs = 20000000 / size;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int r = 0; r < runs; r++) {
+    fft_power(plan, input, power);
+    checksum += power[r % (size / 2 + 1)];
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  printf("%d points: %.1f us per transform (%d)\n", size, seconds / runs * 1e6, checksum > 0);
+
+  fft_destroy(plan);
+  free(power);
+  free(input);
+}
+
+int main(void) {
+  for (int size = 8; size <= 8192; size *= 2) {
+    test_size(size);
+  }
+
+  if (failures > 0) {
+    printf("fft: %d failures\n", failures);
+    return 1;
+  }
+
+  bench(1024);
+  bench(2048);
+  bench(4096);
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+
+#include <glyphs.h>
+
+/*
+** streams every codepoint from latin-1 up to the cjk block through the
+** glyph cache, several passes so the atlas keeps filling up and getting
+** evicted, and prints how many glyph misses it handles per second. placed
+** glyphs are checked to stay inside the atlas and out of the ascii corner.
+** it needs one of the fonts glyphs.c looks for, SAP_FONT picks another.
+*/
+
+#define RESERVED 128
+#define FIRST 0xa0
+#define LAST 0x3000
+#define PASSES 3
+/* glyphs drawn per frame, what is older than the previous frame can go */
+#define PER_FRAME 64
+
+static unsigned char pixels[GLYPH_ATLAS_SIZE * GLYPH_ATLAS_SIZE * 4];
+
+static void before_evict(void) {
+}
+
+int main(void) {
+  glyphs_init(pixels, RESERVED, RESERVED, 16);
+
+  if (glyphs_get(0xe9, 0, before_evict) == NULL) {
+    printf("glyphs: no font found, skipped\n");
+    return 0;
+  }
+
+  int failures = 0, gets = 0, missing = 0;
+  unsigned frame = 1, rasterized = glyphs_rasterized(), generation = glyphs_generation();
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int c = FIRST; c < LAST; c++) {
+      const glyph *g = glyphs_get(c, frame, before_evict);
+
+      if (++gets % PER_FRAME == 0) frame++;
+
+      if (g == NULL) {
+        missing++;
+        continue;
+      }
+
+      SDL_Rect r = g->rect;
+
+      if (g->codepoint != c || r.x < 0 || r.y < 0 || r.x + r.w > GLYPH_ATLAS_SIZE ||
+          r.y + r.h > GLYPH_ATLAS_SIZE || (r.x < RESERVED && r.y < RESERVED)) {
+        printf("FAIL U+%04X placed at %d,%d %dx%d\n", c, r.x, r.y, r.w, r.h);
+        failures++;
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  unsigned misses = glyphs_rasterized() - rasterized;
+
+  printf("glyphs: %.0f misses/s, %u misses and %u evictions in %d lookups, %d not in the font\n",
+    misses / seconds, misses, glyphs_generation() - generation, gets, missing);
+
+  return failures > 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+
+#include <analysis.h>
+#include <loudness.h>
+
+/*
+** feeds reference signals through loudness_process() in callback sized
+** blocks and checks the readings, then prints what the meter costs per
+** second of audio on the analysis thread and what analysis_push() costs the
+** audio callback.
+*/
+
+#define SAMPLE_RATE 48000
+#define SECONDS 20
+#define FRAMES (SAMPLE_RATE * SECONDS)
+#define BLOCK_FRAMES 1024
+
+static int failures = 0;
+
+static void process(loudness *l, const int16_t *samples, int frames) {
+  for (int i = 0; i < frames; i += BLOCK_FRAMES) {
+    loudness_process(l, samples + 2 * i, frames - i < BLOCK_FRAMES ? frames - i : BLOCK_FRAMES);
+  }
+}
+
+static void expect(const char *name, float value, float want, float tolerance) {
+  bool ok = fabsf(value - want) <= tolerance;
+
+  printf("%s %s: %.2f, want %.2f\n", ok ? "ok" : "FAIL", name, value, want);
+  failures += !ok;
+}
+
+/* a stereo sine with the same peak level on both channels, amplitude
+** switched to `second_db` halfway through */
+static void tone(int16_t *samples, double freq, double phase, float first_db, float second_db) {
+  for (int i = 0; i < FRAMES; i++) {
+    double amplitude = pow(10, (i < FRAMES / 2 ? first_db : second_db) / 20);
+    int16_t sample = lrint(32767 * amplitude * sin(2 * M_PI * freq * i / SAMPLE_RATE + phase));
+
+    samples[2 * i] = samples[2 * i + 1] = sample;
+  }
+}
+
+static void test_reference(loudness *l, int16_t *samples) {
+  /* a 1 kHz sine at -20 dBFS on both channels reads -20 LUFS */
+  loudness_reset(l);
+  tone(samples, 1000, 0, -20, -20);
+  process(l, samples, FRAMES);
+
+  expect("momentary", l->momentary, -20, 0.1f);
+  expect("short term", l->short_term, -20, 0.1f);
+  expect("integrated", l->integrated, -20, 0.1f);
+
+  /* the quiet half is more than 10 LU below the ungated mean of -23 LUFS
+  ** and is gated away */
+  loudness_reset(l);
+  tone(samples, 1000, 0, -20, -40);
+  process(l, samples, FRAMES);
+
+  expect("relative gate", l->integrated, -20, 0.1f);
+
+  /* a quarter rate sine sampled 45 degrees off its crests, the samples peak
+  ** 3 dB below the waveform */
+  loudness_reset(l);
+  tone(samples, SAMPLE_RATE / 4, M_PI / 4, -6, -6);
+  process(l, samples, FRAMES);
+
+  expect("true peak", loudness_true_peak_db(l), -6, 0.3f);
+}
+
+static double elapsed(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_process(loudness *l, const int16_t *samples) {
+  struct timespec start;
+  int runs = 10;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int r = 0; r < runs; r++) {
+    process(l, samples, FRAMES);
+  }
+
+  double seconds = elapsed(&start);
+
+  printf("loudness_process: %.2f ms per second of 48 kHz stereo, %.2f%% of a core (%d)\n",
+    seconds * 1000 / (runs * SECONDS), seconds / (runs * SECONDS) * 100, l->integrated < 0);
+}
+
+static void bench_push(const int16_t *samples) {
+  analysis_config config = { 32, 40, 16000, 0.01f, 0.3f, 20.0f };
+  analysis_init(SAMPLE_RATE, &config, 0);
+
+  struct timespec start;
+  int runs = 20000;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int r = 0; r < runs; r++) {
+    analysis_push(samples + (r % 64) * BLOCK_FRAMES * 2, BLOCK_FRAMES);
+  }
+
+  double seconds = elapsed(&start);
+
+  analysis_shutdown();
+
+  printf("analysis_push: %.2f us per %d frames, the callback period is %.0f us\n",
+    seconds / runs * 1e6, BLOCK_FRAMES, 1e6 * BLOCK_FRAMES / SAMPLE_RATE);
+}
+
+int main(void) {
+  int16_t *samples = malloc(FRAMES * 2 * sizeof(int16_t));
+  loudness *l = loudness_create(SAMPLE_RATE);
+
+  test_reference(l, samples);
+
+  if (failures > 0) {
+    printf("loudness: %d failures\n", failures);
+    return 1;
+  }
+
+  tone(samples, 1000, 0, -20, -40);
+  bench_process(l, samples);
+  bench_push(samples);
+
+  loudness_destroy(l);
+  free(samples);
+
+  return 0;
+}
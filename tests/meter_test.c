@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <meter.h>
+
+/*
+** checks the meter kernel picked by meter_init() against a double precision
+** reference and prints its throughput. run once per SAP_METER_ISA value,
+** a kernel the cpu lacks is reported and skipped.
+*/
+
+#define BENCH_FRAMES 1024
+
+static int failures = 0;
+
+static unsigned random_state = 12345;
+
+static int16_t random_sample(void) {
+  random_state = random_state * 1103515245 + 12345;
+  return (int16_t)(random_state >> 16);
+}
+
+typedef struct {
+  double sum_squares[METER_CHANNELS];
+  int peak[METER_CHANNELS];
+  int clipped[METER_CHANNELS];
+} reference;
+
+static void measure_reference(const int16_t *samples, int frames, reference *ref) {
+  memset(ref, 0, sizeof(*ref));
+
+  for (int i = 0; i < frames; i++) {
+    for (int c = 0; c < METER_CHANNELS; c++) {
+      double sample = samples[i * METER_CHANNELS + c];
+      double magnitude = fmin(fabs(sample), METER_CLIP_LEVEL);
+
+      ref->sum_squares[c] += sample * sample;
+      ref->peak[c] = magnitude > ref->peak[c] ? magnitude : ref->peak[c];
+      ref->clipped[c] += magnitude == METER_CLIP_LEVEL;
+    }
+  }
+}
+
+static void expect(const char *name, int frames, const meter_block *block, const reference *ref) {
+  for (int c = 0; c < METER_CHANNELS; c++) {
+    double rms = sqrt(block->sum_squares[c] / (double)(frames > 0 ? frames : 1));
+    double ref_rms = sqrt(ref->sum_squares[c] / (frames > 0 ? frames : 1));
+
+    if (block->frames != frames || (double)block->sum_squares[c] != ref->sum_squares[c] ||
+        fabs(rms - ref_rms) > 1e-9 * (ref_rms + 1) ||
+        block->peak[c] != ref->peak[c] || block->clipped[c] != ref->clipped[c]) {
+      printf("FAIL %s channel %d: frames %d/%d rms %.9f/%.9f peak %d/%d clipped %d/%d\n",
+        name, c, block->frames, frames, rms, ref_rms,
+        block->peak[c], ref->peak[c], block->clipped[c], ref->clipped[c]);
+      failures++;
+    }
+  }
+}
+
+/* lengths around every vector width leave every possible scalar remainder */
+static void test_lengths(void) {
+  int lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1000, 4099 };
+  int16_t *samples = malloc(4099 * METER_CHANNELS * sizeof(int16_t));
+
+  for (int i = 0; i < 4099 * METER_CHANNELS; i++) {
+    samples[i] = random_sample();
+
+    if (i % 97 == 0) samples[i] = -32768;
+    if (i % 89 == 0) samples[i] = 32767;
+  }
+
+  for (int l = 0; l < (int)(sizeof(lengths) / sizeof(lengths[0])); l++) {
+    char name[32];
+    reference ref;
+    meter_block block = { 0 };
+
+    snprintf(name, sizeof(name), "%d frames", lengths[l]);
+    measure_reference(samples, lengths[l], &ref);
+    meter_measure(samples, lengths[l], &block);
+    expect(name, lengths[l], &block, &ref);
+  }
+
+  free(samples);
+}
+
+/* blocks measured one at a time and summed must match one long measurement */
+static void test_accumulate(void) {
+  int frames = 100003;
+  int16_t *samples = malloc(frames * METER_CHANNELS * sizeof(int16_t));
+
+  for (int i = 0; i < frames * METER_CHANNELS; i++) {
+    samples[i] = random_sample();
+  }
+
+  reference ref;
+  meter_block total = { 0 };
+
+  measure_reference(samples, frames, &ref);
+
+  for (int offset = 0; offset < frames; offset += 1000) {
+    meter_block block = { 0 };
+    int count = frames - offset < 1000 ? frames - offset : 1000;
+
+    meter_measure(samples + offset * METER_CHANNELS, count, &block);
+    meter_accumulate(&total, &block);
+  }
+
+  expect("accumulated", frames, &total, &ref);
+
+  free(samples);
+}
+
+/* the vector kernels count clips in 16 bit lanes that are flushed every
+** 16384 vectors, a full scale block long enough to need several flushes
+** would wrap them if one were missed */
+static void test_clip_flush(void) {
+  int frames = (1 << 20) + 5;
+  int16_t *samples = malloc(frames * METER_CHANNELS * sizeof(int16_t));
+
+  for (int i = 0; i < frames * METER_CHANNELS; i++) {
+    samples[i] = i & 2 ? 32767 : -32768;
+  }
+
+  reference ref;
+  meter_block block = { 0 };
+
+  measure_reference(samples, frames, &ref);
+  meter_measure(samples, frames, &block);
+  expect("clip flush", frames, &block, &ref);
+
+  free(samples);
+}
+
+static void bench(void) {
+  int16_t samples[BENCH_FRAMES * METER_CHANNELS];
+
+  for (int i = 0; i < BENCH_FRAMES * METER_CHANNELS; i++) {
+    samples[i] = random_sample();
+  }
+
+  struct timespec start, end;
+  long long checksum = 0;
+  int runs = 20000;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int r = 0; r < runs; r++) {
+    meter_block block = { 0 };
+
+    meter_measure(samples, BENCH_FRAMES, &block);
+    checksum += block.sum_squares[0];
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  double samples_per_second = (double)runs * BENCH_FRAMES * METER_CHANNELS / seconds;
+
+  printf("%s: %.0f Msamples/s (%lld)\n", meter_isa(), samples_per_second / 1e6, checksum & 1);
+}
+
+int main(void) {
+  const char *forced = getenv("SAP_METER_ISA");
+
+  meter_init();
+
+  if (forced != NULL && strcmp(forced, meter_isa()) != 0) {
+    printf("%s: not supported here, skipped\n", forced);
+    return 0;
+  }
+
+  test_lengths();
+  test_accumulate();
+  test_clip_flush();
+
+  if (failures > 0) {
+    printf("%s: %d failures\n", meter_isa(), failures);
+    return 1;
+  }
+
+  bench();
+
+  return 0;
+}
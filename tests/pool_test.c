@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <microui.h>
+
+/*
+** runs random get/init/update/remove sequences on a small mu_Pool over
+** colliding ids and checks every result against a plain reference of which
+** id sits in which item, then times frames of a window with thousands of
+** expanded headers, all of which have to stay expanded.
+*/
+
+#define FUZZ_ITEMS 64
+#define FUZZ_IDS 200
+#define FUZZ_OPS 1000000
+#define BENCH_FRAMES 50
+
+static int failures = 0;
+
+static unsigned random_state = 12345;
+
+static unsigned random_next(void) {
+  random_state = random_state * 1103515245 + 12345;
+  return random_state >> 8;
+}
+
+/* every item of the pool as the reference sees it, -1 ids are free */
+static mu_Id ref_id[FUZZ_ITEMS];
+static int ref_last[FUZZ_ITEMS];
+static int ref_free[FUZZ_ITEMS];
+static int ref_free_count;
+
+static int ref_find(mu_Id id) {
+  for (int i = 0; i < FUZZ_ITEMS; i++) {
+    if (ref_id[i] == id) return i;
+  }
+
+  return -1;
+}
+
+/* half the ids share their low bits and land in one probe chain */
+static mu_Id fuzz_id(int k) {
+  return k % 2 ? (mu_Id)(k * 4096 + 1) : (mu_Id)(k * 2654435761u) | 1;
+}
+
+static void fail(const char *op, int step, mu_Id id, int got, int want) {
+  if (failures++ < 10) {
+    printf("FAIL %s step %d: id %08x at %d, want %d\n", op, step, id, got, want);
+  }
+}
+
+static void fuzz(void) {
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  mu_init_ex(ctx, 1, FUZZ_ITEMS);
+  mu_Pool *pool = &ctx->treenode_pool;
+
+  for (int i = 0; i < FUZZ_ITEMS; i++) {
+    ref_id[i] = (mu_Id) -1;
+    ref_free[i] = FUZZ_ITEMS - 1 - i;
+  }
+
+  ref_free_count = FUZZ_ITEMS;
+  ctx->frame = 1;
+
+  for (int step = 0; step < FUZZ_OPS && failures == 0; step++) {
+    mu_Id id = fuzz_id(random_next() % FUZZ_IDS);
+    int want = ref_find(id);
+    int op = random_next() % 100;
+
+    if (op < 40) {
+      int got = mu_pool_get(ctx, pool, id);
+      if (got != want) fail("get", step, id, got, want);
+    } else if (op < 70 && want == -1) {
+      /* a full pool gives up the first of its least recently used items,
+      ** never one used this frame */
+      if (ref_free_count > 0) {
+        want = ref_free[--ref_free_count];
+      } else {
+        int oldest = ctx->frame;
+
+        for (int i = 0; i < FUZZ_ITEMS; i++) {
+          if (ref_last[i] < oldest) {
+            oldest = ref_last[i];
+            want = i;
+          }
+        }
+
+        if (want == -1) continue;
+      }
+
+      int got = mu_pool_init(ctx, pool, id);
+      if (got != want) fail("init", step, id, got, want);
+
+      ref_id[want] = id;
+      ref_last[want] = ctx->frame;
+    } else if (op < 90 && want >= 0) {
+      mu_pool_remove(ctx, pool, want);
+
+      ref_id[want] = (mu_Id) -1;
+      ref_free[ref_free_count++] = want;
+    } else if (op < 95 && want >= 0) {
+      mu_pool_update(ctx, pool, want);
+      ref_last[want] = ctx->frame;
+    } else {
+      ctx->frame++;
+    }
+  }
+
+  /* whatever the reference holds must still be found where it put it */
+  for (int i = 0; i < FUZZ_ITEMS; i++) {
+    if (ref_id[i] != (mu_Id) -1 && mu_pool_get(ctx, pool, ref_id[i]) != i) {
+      fail("final get", FUZZ_OPS, ref_id[i], mu_pool_get(ctx, pool, ref_id[i]), i);
+    }
+  }
+
+  mu_free(ctx);
+  free(ctx);
+}
+
+static int text_width(mu_Font font, const char *text, int len) {
+  return 8 * (len == -1 ? (int) strlen(text) : len);
+}
+
+static int text_height(mu_Font font) {
+  return 18;
+}
+
+/* one frame of `count` headers, expanding the ones that are not yet.
+** returns how many were expanded when drawn */
+static int header_frame(mu_Context *ctx, int count) {
+  int expanded = 0;
+  char label[32];
+
+  mu_begin(ctx);
+
+  if (mu_begin_window(ctx, "tree", mu_rect(0, 0, 300, 600))) {
+    for (int i = 0; i < count; i++) {
+      int len = snprintf(label, sizeof(label), "folder %d", i);
+      mu_Id id = mu_get_id(ctx, label, len);
+
+      if (mu_pool_get(ctx, &ctx->treenode_pool, id) < 0) {
+        mu_pool_init(ctx, &ctx->treenode_pool, id);
+      }
+
+      expanded += (mu_header(ctx, label) & MU_RES_ACTIVE) != 0;
+    }
+
+    mu_end_window(ctx);
+  }
+
+  mu_end(ctx);
+
+  return expanded;
+}
+
+static void bench(int count) {
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  mu_init_ex(ctx, MU_CONTAINERPOOL_SIZE, count);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+
+  header_frame(ctx, count);
+
+  struct timespec start, end;
+  int expanded = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (int f = 0; f < BENCH_FRAMES; f++) {
+    expanded = header_frame(ctx, count);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  if (expanded != count) {
+    printf("FAIL %d headers: %d stayed expanded\n", count, expanded);
+    failures++;
+  }
+
+  printf("%d expanded headers: %.3f ms per frame\n", count, seconds * 1000 / BENCH_FRAMES);
+
+  mu_free(ctx);
+  free(ctx);
+}
+
+int main(void) {
+  fuzz();
+
+  if (failures > 0) {
+    printf("pool: %d failures\n", failures);
+    return 1;
+  }
+
+  printf("pool: %d operations agree with the reference\n", FUZZ_OPS);
+
+  bench(1000);
+  bench(4000);
+  bench(16000);
+
+  return failures > 0;
+}
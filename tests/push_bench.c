@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include <microui.h>
+#include <renderer.h>
+
+/*
+** times only the queueing of quads, what push_quad() costs per rect drawn.
+** each frame stays under the batch limit so nothing is submitted while the
+** clock runs, the clear and the present are left out.
+*/
+
+#define QUADS 60000
+#define FRAMES 200
+
+int main(void) {
+  SDL_setenv("SAP_HEADLESS", "1", 1);
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+  SDL_setenv("SAP_NOVSYNC", "1", 1);
+
+  SDL_Init(SDL_INIT_VIDEO);
+  sdlr_init();
+
+  int failures = 0;
+  double freq = SDL_GetPerformanceFrequency();
+  Uint64 ticks = 0;
+
+  for (int f = 0; f < FRAMES; f++) {
+    sdlr_clear(mu_color(10, 10, 23, 255));
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < QUADS; i++) {
+      sdlr_draw_rect(mu_rect(i % 200 * 4, i / 200 % 175 * 4, 4, 4), mu_color(i, i >> 8, 200, 255));
+    }
+
+    /* the first frame grows the batch, it is not timed */
+    if (f > 0) ticks += SDL_GetPerformanceCounter() - start;
+
+    sdlr_present();
+
+    const sdlr_stats *stats = sdlr_get_stats();
+
+    if (stats->quads != QUADS || stats->batches != 1) {
+      printf("FAIL frame %d: %d quads in %d batches, want %d in 1\n",
+        f, stats->quads, stats->batches, QUADS);
+      failures++;
+    }
+  }
+
+  double seconds = ticks / freq;
+
+  printf("push_quad: %.2f Mquads/s, %.2f ns per quad\n",
+    (double)QUADS * (FRAMES - 1) / seconds / 1e6, seconds * 1e9 / ((double)QUADS * (FRAMES - 1)));
+
+  SDL_Quit();
+
+  return failures > 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include <microui.h>
+#include <renderer.h>
+
+/*
+** draws frames of 200k quads headless, several times what one batch holds,
+** and prints the throughput. every quad must be submitted, in as many
+** batches as the batch limit requires, before the frame is presented.
+*/
+
+#define QUADS 200000
+#define FRAMES 10
+#define BATCH_MAX 65536
+
+int main(void) {
+  SDL_setenv("SAP_HEADLESS", "1", 1);
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+  SDL_setenv("SAP_NOVSYNC", "1", 1);
+
+  SDL_Init(SDL_INIT_VIDEO);
+  sdlr_init();
+
+  int failures = 0;
+  long long quads = 0;
+  double freq = SDL_GetPerformanceFrequency();
+
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  for (int f = 0; f < FRAMES; f++) {
+    sdlr_clear(mu_color(10, 10, 23, 255));
+
+    for (int i = 0; i < QUADS; i++) {
+      sdlr_draw_rect(mu_rect(i % 200 * 4, i / 200 % 175 * 4, 4, 4), mu_color(i, i >> 8, 200, 255));
+    }
+
+    sdlr_present();
+
+    const sdlr_stats *stats = sdlr_get_stats();
+    int batches = (QUADS + BATCH_MAX - 1) / BATCH_MAX;
+
+    if (stats->quads != QUADS || stats->batches != batches) {
+      printf("FAIL frame %d: %d quads in %d batches, want %d in %d\n",
+        f, stats->quads, stats->batches, QUADS, batches);
+      failures++;
+    }
+
+    quads += stats->quads;
+  }
+
+  double seconds = (SDL_GetPerformanceCounter() - start) / freq;
+
+  printf("%d quads per frame: %.2f Mquads/s, %.2f ms per frame\n",
+    QUADS, quads / seconds / 1e6, seconds * 1000 / FRAMES);
+
+  SDL_Quit();
+
+  return failures > 0;
+}
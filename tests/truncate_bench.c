@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include <microui.h>
+#include <renderer.h>
+#include <truncate.h>
+
+/*
+** cuts a window full of long file names the way the file window does,
+** headless, and prints what a frame of them costs when the cuts are
+** remembered and when a resize makes every name be measured again. each
+** cut has to fit, end in "..." and keep the longest prefix that does.
+*/
+
+#define NAMES 300
+#define NAME_BYTES 116
+#define FRAMES 200
+
+static char names[NAMES][NAME_BYTES];
+static int failures = 0;
+
+static int text_width(mu_Font font, const char *text, int len) {
+  if (len == -1) { len = strlen(text); }
+  return sdlr_get_text_width(text, len);
+}
+
+static int text_height(mu_Font font) {
+  return sdlr_get_text_height();
+}
+
+static void make_names(void) {
+  for (int i = 0; i < NAMES; i++) {
+    snprintf(names[i], NAME_BYTES, "%03d - Some Artist feat. Another Artist - A Rather Long Track "
+      "Title (Extended Remix) [Remastered %d] - Bj\xc3\xb6rk", i, 1990 + i % 30);
+  }
+}
+
+static void check(const char *name, const char *cut, int width, int result) {
+  int len = strlen(cut), dots = sdlr_get_text_width("...", 3);
+
+  if (strcmp(name, cut) == 0) {
+    if (result != sdlr_get_text_width(name, strlen(name)) || result > width) {
+      printf("FAIL \"%s\" left whole at %d px in %d\n", name, result, width);
+      failures++;
+    }
+
+    return;
+  }
+
+  /* one more character of the name would not have fit */
+  const char *next = cut + len - 3;
+  int next_len = 1;
+
+  while ((next[next_len] & 0xc0) == 0x80) next_len++;
+
+  if (len < 3 || strcmp(cut + len - 3, "...") != 0 || strncmp(name, cut, len - 3) != 0 ||
+      result != sdlr_get_text_width(cut, len) || result > width ||
+      sdlr_get_text_width(name, len - 3 + next_len) + dots <= width) {
+    printf("FAIL \"%s\" cut to \"%s\" at %d px in %d\n", name, cut, result, width);
+    failures++;
+  }
+}
+
+/* one frame of every name in a window `w` wide, the time spent cutting in
+** us. like the file window each name starts out as a fresh copy */
+static double frame(mu_Context *ctx, int w, bool verify) {
+  static char cut[NAMES][NAME_BYTES];
+  static int result[NAMES];
+  Uint64 ticks = 0;
+
+  mu_begin(ctx);
+
+  /* a window keeps its rect after the first frame, resizing is done by hand */
+  mu_get_container(ctx, "Files")->rect = mu_rect(0, 0, w, 600);
+
+  if (mu_begin_window(ctx, "Files", mu_rect(0, 0, w, 600))) {
+    int width = mu_get_current_container(ctx)->rect.w - 15;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < NAMES; i++) {
+      memcpy(cut[i], names[i], NAME_BYTES);
+      result[i] = truncate_text(ctx, cut[i]);
+    }
+
+    ticks = SDL_GetPerformanceCounter() - start;
+
+    for (int i = 0; i < NAMES && verify; i++) {
+      check(names[i], cut[i], width, result[i]);
+    }
+
+    mu_end_window(ctx);
+  }
+
+  mu_end(ctx);
+
+  return ticks * 1e6 / SDL_GetPerformanceFrequency();
+}
+
+int main(void) {
+  SDL_setenv("SAP_HEADLESS", "1", 1);
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+  SDL_Init(SDL_INIT_VIDEO);
+  sdlr_init();
+
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+
+  make_names();
+
+  double cached = 0, resized = 0;
+
+  for (int f = 0; f < FRAMES; f++) {
+    /* every other frame a different width, nothing is remembered */
+    resized += frame(ctx, f % 2 ? 300 : 420, f < 2);
+  }
+
+  for (int f = 0; f < FRAMES; f++) {
+    cached += frame(ctx, 300, f == 0);
+  }
+
+  printf("%d names of %d bytes: %.1f us per frame remembered, %.1f us per frame resized\n",
+    NAMES, NAME_BYTES - 1, cached / FRAMES, resized / FRAMES);
+
+  mu_free(ctx);
+  free(ctx);
+
+  SDL_Quit();
+
+  return failures > 0;
+}